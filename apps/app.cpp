@@ -4,6 +4,7 @@
 // Read online: https://github.com/ocornut/imgui/tree/master/docs
 
 #include "explorer.h"
+#include "allocationCounter.h"
 #include <libsom/DataSet.hpp>
 #include <libsom/SqliteDataLoader.hpp>
 #include <libsom/MnistDataLoader.hpp>
@@ -85,6 +86,7 @@ int main(int, char **)
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
+    VSOMExplorer::AllocationCounter::installImGuiAllocator();
     ImGui::CreateContext();
     ImGuiIO &io = ImGui::GetIO();
     (void)io;
@@ -137,6 +139,10 @@ int main(int, char **)
     //     return 0;
     
     auto explorer = VSOMExplorer::Handler{};
+
+    // Restore the last session, heavy parts load in the background after the first frame
+    const auto workspacePath = std::string{"session.vsom"};
+    explorer.OpenWorkspace(workspacePath);
         
     // auto dataset = std::unique_ptr<DataSet>(new DataSet(*dbConnection));
     
@@ -195,6 +201,12 @@ int main(int, char **)
         SDL_GL_SwapWindow(window);
     }
 
+    /* A half-trained model is not saved over the last good one, and before the session has been
+       loaded the explorer still holds the default map */
+    explorer.StopTraining();
+    if (!explorer.isWorkspaceLoading())
+        explorer.SaveWorkspace(workspacePath);
+
     // Cleanup
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplSDL2_Shutdown();
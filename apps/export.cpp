@@ -0,0 +1,176 @@
+// Headless batch export of map images, no SDL or OpenGL involved.
+//
+// Usage: VSOM-Export [options] <workspace.vsom | model checkpoint>...
+//   --out <dir>       output directory (default .)
+//   --size <W>x<H>    image size in pixels (default 512x512)
+//   --views <list>    comma separated subset of umatrix,hits,components,rgb (default all)
+//   --spec <file>     column spec for SQLite datasets (default ../data/columnSpec.txt),
+//                     CSV, TSV and IDX datasets are recognized without one
+
+#include "dataLoaders.h"
+#include "mapRaster.h"
+#include "workspace.h"
+
+#include <libsom/DataSet.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace VSOMExplorer;
+
+namespace
+{
+    struct Options
+    {
+        std::string outputDirectory = ".";
+        size_t width{512};
+        size_t height{512};
+        std::string views = "umatrix,hits,components,rgb";
+        std::string columnSpec = "../data/columnSpec.txt";
+        std::vector<std::string> inputs = std::vector<std::string>{};
+    };
+
+    bool wants(const Options &options, const std::string &view)
+    {
+        return ("," + options.views + ",").find("," + view + ",") != std::string::npos;
+    }
+
+    int usage()
+    {
+        std::cerr << "Usage: VSOM-Export [--out dir] [--size WxH] [--views umatrix,hits,components,rgb] [--spec columnSpec] <workspace.vsom | model>...\n";
+        return 1;
+    }
+
+    bool exportModel(const Options &options, const std::string &input)
+    {
+        /* Workspaces bring the dataset, feature selection and color ranges along, bare checkpoints only the model */
+        auto workspace = std::filesystem::path(input).extension() == ".vsom" ? Workspace::load(input) : std::optional<Workspace>{};
+        const auto modelPath = workspace ? workspace->modelPath : input;
+
+        const auto codebook = Codebook::load(modelPath);
+        if (!codebook)
+        {
+            std::cerr << "Could not read model " << modelPath << '\n';
+            return false;
+        }
+
+        auto names = std::vector<std::string>{};
+        auto hits = std::optional<ValueGrid>{};
+        if (workspace && !workspace->datasetPath.empty() && (wants(options, "hits") || wants(options, "components")))
+        {
+            auto loader = openDataLoader(workspace->datasetPath, options.columnSpec);
+            if (loader != nullptr)
+            {
+                auto dataset = DataSet(*loader);
+                names = dataset.getNames();
+
+                if (wants(options, "hits") && dataset.vectorLength() == codebook->getDepth())
+                {
+                    auto weights = std::vector<float>(dataset.vectorLength());
+                    for (size_t column{0}; column < weights.size(); ++column)
+                        weights[column] = dataset.getWeight(column);
+
+                    hits = MapRaster::computeBmuHits(*codebook, *denseMatrix(loader.get(), dataset), weights, workspace->training.searchMode);
+                }
+            }
+        }
+
+        auto views = std::vector<MapRaster::View>{};
+        if (wants(options, "umatrix"))
+            views.push_back(MapRaster::View{MapRaster::Layer::UMatrix, "umatrix", 0, 0, 0, 0, workspace ? workspace->uMatrixRange : ColorRange{}});
+        if (wants(options, "hits") && hits)
+            views.push_back(MapRaster::View{MapRaster::Layer::BmuHits, "hits", 0, 0, 0, 0, workspace ? workspace->bmuHitsRange : ColorRange{}});
+        if (wants(options, "components"))
+        {
+            for (size_t feature{0}; feature < codebook->getDepth(); ++feature)
+            {
+                const auto name = feature < names.size() ? names[feature] : std::to_string(feature);
+                views.push_back(MapRaster::View{MapRaster::Layer::ComponentPlane, "component-" + name, feature, 0, 0, 0, ColorRange{}});
+            }
+        }
+        /* Exported images use the colormap the workspace was last viewed with */
+        for (auto &view : views)
+        {
+            view.colormap = workspace ? workspace->colormap : ColormapName::Grayscale;
+            view.colormapEntries = workspace ? workspace->colormapEntries : Colormap::coarseEntries;
+            view.logScale = workspace && view.layer == MapRaster::Layer::BmuHits && workspace->bmuHitsLogScale;
+        }
+        if (wants(options, "rgb"))
+        {
+            auto view = MapRaster::View{MapRaster::Layer::FeatureRgb, "rgb"};
+            view.redColumnId = workspace ? workspace->redColumnId : 0;
+            view.greenColumnId = workspace ? workspace->greenColumnId : std::min<size_t>(1, codebook->getDepth() - 1);
+            view.blueColumnId = workspace ? workspace->blueColumnId : std::min<size_t>(2, codebook->getDepth() - 1);
+            views.push_back(view);
+        }
+
+        const auto images = MapRaster::rasterizeAll(*codebook, hits ? &*hits : nullptr, views, options.width, options.height);
+
+        const auto stem = std::filesystem::path(input).stem().string();
+        bool success = true;
+        for (size_t i{0}; i < views.size(); ++i)
+        {
+            const auto path = std::filesystem::path(options.outputDirectory) / (stem + "-" + views[i].name + ".png");
+            if (!writePng(path.string(), images[i]))
+            {
+                std::cerr << "Could not write " << path << '\n';
+                success = false;
+            }
+        }
+
+        return success;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    auto options = Options{};
+
+    for (int i{1}; i < argc; ++i)
+    {
+        const auto argument = std::string(argv[i]);
+        const bool hasValue = i + 1 < argc;
+
+        if (argument == "--out" && hasValue)
+            options.outputDirectory = argv[++i];
+        else if (argument == "--views" && hasValue)
+            options.views = argv[++i];
+        else if (argument == "--spec" && hasValue)
+            options.columnSpec = argv[++i];
+        else if (argument == "--size" && hasValue)
+        {
+            if (std::sscanf(argv[++i], "%zux%zu", &options.width, &options.height) != 2 || options.width == 0 || options.height == 0)
+                return usage();
+        }
+        else if (argument.rfind("--", 0) == 0)
+            return usage();
+        else
+            options.inputs.push_back(argument);
+    }
+
+    if (options.inputs.empty())
+        return usage();
+
+    std::filesystem::create_directories(options.outputDirectory);
+
+    int failures{0};
+    for (const auto &input : options.inputs)
+    {
+        try
+        {
+            if (!exportModel(options, input))
+                ++failures;
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << input << ": " << e.what() << '\n';
+            ++failures;
+        }
+    }
+
+    return failures == 0 ? 0 : 2;
+}
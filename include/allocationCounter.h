@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+/* Heap allocation counting for debugging the frame path, build with VSOM_COUNT_ALLOCATIONS defined
+   (make COUNT_ALLOCATIONS=1) to replace the global operator new and the ImGui allocator. */
+namespace VSOMExplorer::AllocationCounter
+{
+    constexpr bool isEnabled()
+    {
+#ifdef VSOM_COUNT_ALLOCATIONS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /* Routes ImGui's allocations through the counter, call before ImGui::CreateContext */
+    void installImGuiAllocator();
+
+    size_t heapAllocations();
+    size_t imGuiAllocations();
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "codebook.h"
+
+#include <atomic>
+#include <limits>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    enum class BmuSearchMode
+    {
+        Exhaustive,
+        Hierarchical,
+        Local
+    };
+
+    /* Best matching unit lookup against a live codebook.
+       Hierarchical searches a pyramid of 2x2-averaged maps from the coarsest level down,
+       Local walks downhill from the sample's previous BMU, seeded hierarchically on first sight. Both fall back to the
+       exhaustive scan when verification is requested, which also feeds the recall counters. */
+    class BmuSearch
+    {
+    public:
+        static constexpr size_t noPreviousBmu = std::numeric_limits<size_t>::max();
+
+        BmuSearch(const Codebook &codebook, const std::vector<float> &weights, BmuSearchMode mode);
+
+        /* Rebuilds the coarse levels, must be called when the codebook has changed substantially */
+        void rebuild();
+
+        size_t find(const float *sample, size_t previousBmu = noPreviousBmu, bool verify = false);
+        size_t findExhaustive(const float *sample) const;
+
+        float distance(const float *sample, size_t neuron) const;
+
+        BmuSearchMode getMode() const { return m_mode; }
+        size_t getVerifiedCount() const { return m_verified; }
+        size_t getVerifiedHits() const { return m_verifiedHits; }
+        float getRecall() const;
+        void resetRecall();
+
+    private:
+        struct Level
+        {
+            size_t width{0};
+            size_t height{0};
+            std::vector<float> values = std::vector<float>{};
+
+            const float *getNeuron(size_t x, size_t y, size_t depth) const { return values.data() + (y * width + x) * depth; }
+        };
+
+        struct Candidate
+        {
+            float distance;
+            size_t x;
+            size_t y;
+        };
+
+        static constexpr size_t coarsestSize = 8;
+        static constexpr size_t beamWidth = 3;
+        /* Cells of one refinement window */
+        static constexpr size_t windowCells = 16;
+        static constexpr size_t maxLocalSteps = 64;
+
+        const Codebook &m_codebook;
+        const std::vector<float> &m_weights;
+        BmuSearchMode m_mode;
+
+        /* m_levels[0] is the first downsampled level, the full resolution map is read from m_codebook */
+        std::vector<Level> m_levels = std::vector<Level>{};
+
+        std::atomic<size_t> m_verified{0};
+        std::atomic<size_t> m_verifiedHits{0};
+
+        size_t findHierarchical(const float *sample) const;
+        size_t findLocal(const float *sample, size_t start) const;
+    };
+}
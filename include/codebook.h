@@ -0,0 +1,48 @@
+#pragma once
+
+#include <libsom/SOM.hpp>
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    /* Flat row-major copy of the model vectors of a Som, neuron index = y * width + x */
+    class Codebook
+    {
+    private:
+        size_t m_width{0};
+        size_t m_height{0};
+        size_t m_depth{0};
+        std::vector<float> m_values = std::vector<float>{};
+
+        template <typename Getter>
+        static Codebook copyFromSom(const Som &som, Getter getNeuron);
+
+    public:
+        Codebook() = default;
+        Codebook(size_t width, size_t height, size_t depth);
+
+        static Codebook fromSom(const Som &som);
+        static Codebook sigmaFromSom(const Som &som);
+        void applyTo(Som &som) const;
+
+        /* Binary checkpoint: width, height and depth as uint64 followed by the raw floats */
+        bool save(const std::string &path) const;
+        static std::optional<Codebook> load(const std::string &path);
+
+        size_t getWidth() const { return m_width; }
+        size_t getHeight() const { return m_height; }
+        size_t getDepth() const { return m_depth; }
+        size_t size() const { return m_width * m_height; }
+        bool empty() const { return m_values.empty(); }
+
+        size_t getIndex(size_t x, size_t y) const { return y * m_width + x; }
+        const float *getNeuron(size_t index) const { return m_values.data() + index * m_depth; }
+        float *getNeuron(size_t index) { return m_values.data() + index * m_depth; }
+
+        const std::vector<float> &getValues() const { return m_values; }
+        size_t memoryBytes() const { return m_values.capacity() * sizeof(float); }
+    };
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    /* Zoom into part of the 0-255 scaled value range, as set by the Upper and Lower sliders */
+    struct ColorRange
+    {
+        float upper{255.0f};
+        float lower{0.0f};
+    };
+
+    enum class ColormapName
+    {
+        Grayscale,
+        Viridis,
+        Magma,
+        Diverging
+    };
+
+    inline constexpr const char *colormapNames[] = {"Grayscale", "Viridis", "Magma", "Diverging"};
+    inline constexpr size_t colormapCount = sizeof(colormapNames) / sizeof(colormapNames[0]);
+
+    /* Lookup table colormap for the map windows and exported images.
+       Colors are packed with red in the low byte, the layout of IM_COL32 and of RGBA bytes on little endian. */
+    class Colormap
+    {
+    private:
+        ColormapName m_name;
+        std::vector<uint32_t> m_lut = std::vector<uint32_t>{};
+
+    public:
+        static constexpr size_t coarseEntries = 256;
+        static constexpr size_t fineEntries = 4096;
+
+        explicit Colormap(ColormapName name = ColormapName::Grayscale, size_t entries = coarseEntries);
+
+        ColormapName getName() const { return m_name; }
+        size_t getEntries() const { return m_lut.size(); }
+
+        /* Normalizes values to [min, max], zooms into range and looks the result up, all in one pass.
+           logScale maps log(1 + value) instead, meant for hit counts. */
+        void apply(const float *values, size_t count, float min, float max, const ColorRange &range, bool logScale, uint32_t *colors) const;
+    };
+
+    /* Linear map of [min, max] onto 0-255, clamped */
+    void scaleToBytes(const float *values, size_t count, float min, float max, uint8_t *bytes);
+
+    inline uint8_t scaleToByte(float value, float min, float max)
+    {
+        const auto scaled = (value - min) * (255.f / (max - min));
+        return static_cast<uint8_t>(scaled > 255.f ? 255.f : scaled > 0.f ? scaled
+                                                                          : 0.f);
+    }
+
+    inline uint32_t packColor(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha = 255)
+    {
+        return static_cast<uint32_t>(red) | static_cast<uint32_t>(green) << 8 | static_cast<uint32_t>(blue) << 16 | static_cast<uint32_t>(alpha) << 24;
+    }
+}
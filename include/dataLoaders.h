@@ -0,0 +1,67 @@
+#pragma once
+
+#include "dataMatrix.h"
+
+#include <libsom/DataSet.hpp>
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    enum class DataFormat
+    {
+        Unknown,
+        Sqlite,
+        Csv,
+        Tsv,
+        Idx
+    };
+
+    const char *dataFormatName(DataFormat format);
+
+    /* Sniffs the first bytes of the file: the SQLite header, the IDX magic number, otherwise text
+       with the delimiter taken from whichever of tab and comma dominates the first line */
+    DataFormat detectDataFormat(const std::string &path);
+
+    /* Parses a decimal number in [begin, end), surrounding blanks and quotes allowed.
+       Returns false if anything but a single number is found. */
+    bool parseFloat(const char *begin, const char *end, float *value);
+
+    /* Delimited text, memory mapped and parsed in newline aligned chunks on all cores.
+       A first line without any numeric field is taken as column names. Quoted fields may not
+       contain the delimiter or line breaks. A row with a missing or unreadable field fails the read. */
+    std::optional<DataMatrix> readDelimited(const std::string &path, char delimiter, size_t threads = 0);
+
+    /* IDX files as used by MNIST: the first dimension is rows, the rest is flattened into columns */
+    std::optional<DataMatrix> readIdx(const std::string &path);
+
+    /* Serves a file read by one of the readers above to libsom. The parsed matrix is kept
+       and can be shared with the in-app trainer instead of copying it out of the DataSet again. */
+    class MatrixDataLoader : public IDataLoader
+    {
+    private:
+        DataFormat m_format;
+        std::shared_ptr<DataMatrix> m_matrix = std::shared_ptr<DataMatrix>();
+
+    public:
+        explicit MatrixDataLoader(DataFormat format) : m_format{format} {}
+
+        int open(const char *path) override;
+        size_t getDepth() const override;
+        std::vector<std::string> getNames() const override;
+        size_t getNumberOfRows() const override;
+        Eigen::VectorXf getRow(size_t index) const override;
+
+        const std::shared_ptr<DataMatrix> &getMatrix() const { return m_matrix; }
+    };
+
+    /* Picks the loader for the file's format and opens it, nullptr if either fails.
+       The column spec is only used by SQLite datasets. */
+    std::unique_ptr<IDataLoader> openDataLoader(const std::string &path, const std::string &columnSpec);
+
+    /* The loader's own matrix for files read by MatrixDataLoader, otherwise a copy out of the dataset */
+    std::shared_ptr<DataMatrix> denseMatrix(const IDataLoader *loader, DataSet &dataset);
+}
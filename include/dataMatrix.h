@@ -0,0 +1,36 @@
+#pragma once
+
+#include <libsom/DataSet.hpp>
+
+#include <string>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    /* Dense row-major copy of a dataset, used by the in-app training and projection code */
+    class DataMatrix
+    {
+    private:
+        size_t m_rows{0};
+        size_t m_columns{0};
+        std::vector<float> m_values = std::vector<float>{};
+        std::vector<std::string> m_names = std::vector<std::string>{};
+
+    public:
+        DataMatrix() = default;
+        DataMatrix(size_t rows, size_t columns);
+
+        static DataMatrix fromDataSet(DataSet &dataset);
+
+        size_t size() const { return m_rows; }
+        size_t vectorLength() const { return m_columns; }
+
+        const float *getRow(size_t index) const { return m_values.data() + index * m_columns; }
+        float *getRow(size_t index) { return m_values.data() + index * m_columns; }
+
+        const std::vector<std::string> &getNames() const { return m_names; }
+        void setNames(std::vector<std::string> names) { m_names = std::move(names); }
+
+        size_t memoryBytes() const { return m_values.capacity() * sizeof(float); }
+    };
+}
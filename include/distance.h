@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VSOM_DISTANCE_SSE2
+#endif
+
+namespace VSOMExplorer
+{
+    /* Eight lanes per step in two accumulators, the remainder is added one by one. The summation order
+       depends only on the length, so every caller gets the same result for the same vectors. */
+    inline float weightedSquaredDistance(const float *a, const float *b, const float *weights, size_t length)
+    {
+        size_t i{0};
+        float sum{0.f};
+#ifdef VSOM_DISTANCE_SSE2
+        auto first = _mm_setzero_ps();
+        auto second = _mm_setzero_ps();
+        for (; i + 8 <= length; i += 8)
+        {
+            const auto firstDifference = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+            const auto secondDifference = _mm_sub_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4));
+            first = _mm_add_ps(first, _mm_mul_ps(_mm_loadu_ps(weights + i), _mm_mul_ps(firstDifference, firstDifference)));
+            second = _mm_add_ps(second, _mm_mul_ps(_mm_loadu_ps(weights + i + 4), _mm_mul_ps(secondDifference, secondDifference)));
+        }
+        if (i + 4 <= length)
+        {
+            const auto difference = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+            first = _mm_add_ps(first, _mm_mul_ps(_mm_loadu_ps(weights + i), _mm_mul_ps(difference, difference)));
+            i += 4;
+        }
+
+        const auto lanes = _mm_add_ps(first, second);
+        const auto pairs = _mm_add_ps(lanes, _mm_movehl_ps(lanes, lanes));
+        sum = _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+#endif
+        for (; i < length; ++i)
+        {
+            const auto difference = a[i] - b[i];
+            sum += weights[i] * difference * difference;
+        }
+        return sum;
+    }
+}
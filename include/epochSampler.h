@@ -0,0 +1,56 @@
+#pragma once
+
+#include "dataMatrix.h"
+
+#include <random>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    enum class EpochSampling
+    {
+        Full,
+        Fraction,
+        Reservoir
+    };
+
+    /* Picks the rows an epoch trains on. Fraction keeps every row with the given probability,
+       Reservoir draws a fixed number of rows. With a label column both take the same share
+       from every class, rows whose label is not a number are then left out of sampled epochs.
+       A column with more than maxClasses distinct values is not a label, sampling stays unstratified.
+       Samples are returned in ascending row order and only depend on the seed. */
+    class EpochSampler
+    {
+    private:
+        const DataMatrix &m_data;
+        EpochSampling m_sampling;
+        double m_fraction;
+        size_t m_sampleSize;
+        std::mt19937 m_random;
+
+        /* Rows per distinct label value, a single stratum when there is no label column */
+        std::vector<std::vector<size_t>> m_strata = std::vector<std::vector<size_t>>{};
+        size_t m_stratifiedRows{0};
+        bool m_tooManyClasses{false};
+        std::vector<size_t> m_allRows = std::vector<size_t>{};
+        std::vector<size_t> m_rows = std::vector<size_t>{};
+
+        void reservoir(const std::vector<size_t> &candidates, size_t count);
+        void bernoulli(const std::vector<size_t> &candidates);
+        std::vector<size_t> stratumQuotas(size_t total) const;
+
+    public:
+        static constexpr long noLabelColumn = -1;
+        static constexpr size_t maxClasses = 256;
+
+        EpochSampler(const DataMatrix &data, EpochSampling sampling, double fraction, size_t sampleSize,
+                     long labelColumn, unsigned seed);
+
+        /* Rows for the next epoch, every row when full is set */
+        const std::vector<size_t> &next(bool full = false);
+
+        bool isSampling() const { return m_sampling != EpochSampling::Full; }
+        size_t getStrataCount() const { return m_strata.size(); }
+        bool hasTooManyClasses() const { return m_tooManyClasses; }
+    };
+}
@@ -2,20 +2,75 @@
 
 #include <libsom/SOM.hpp>
 #include <libsom/DataSet.hpp>
-#include <libsom/SqliteDataLoader.hpp>
 #include <imgui/imgui.h>
 #include "ImGuiFileDialog/ImGuiFileDialog.h"
 
+#include "codebook.h"
+#include "colormap.h"
+#include "dataLoaders.h"
+#include "dataMatrix.h"
+#include "frameArena.h"
+#include "hexGeometry.h"
+#include "labelMaps.h"
+#include "nearestNeighbours.h"
+#include "memoryBudget.h"
+#include "trainingHistory.h"
+#include "trainer.h"
+#include "viewCache.h"
+#include "workspace.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <optional>
+#include <thread>
 
 namespace VSOMExplorer
 {
     class Handler
     {
     private:
+        using PreviewData = decltype(std::declval<DataSet &>().getPreviewData(0));
+
+        struct LoadedDataset
+        {
+            std::unique_ptr<IDataLoader> loader = std::unique_ptr<IDataLoader>();
+            std::unique_ptr<DataSet> dataset = std::unique_ptr<DataSet>();
+        };
+
+        struct DerivedViews
+        {
+            std::optional<PreviewData> previewData = std::optional<PreviewData>{};
+            std::shared_ptr<DataMatrix> dataMatrix = std::shared_ptr<DataMatrix>();
+        };
+
+        struct QueryResult
+        {
+            std::vector<Neighbour> neurons = std::vector<Neighbour>{};
+            std::vector<Neighbour> rows = std::vector<Neighbour>{};
+            size_t revision{ModelViews::noGeneration};
+            size_t mapWidth{0};
+            double milliseconds{0.0};
+        };
+
+        struct HistoryFrame
+        {
+            size_t epoch{0};
+            size_t reset{0};
+            Codebook codebook = Codebook{};
+            ValueGrid uMatrix = ValueGrid{};
+            ValueGrid bmuHits = ValueGrid{};
+        };
+
         std::unique_ptr<IDataLoader> m_dataLoader = std::unique_ptr<IDataLoader>();
         std::unique_ptr<DataSet> m_dataset = std::unique_ptr<DataSet>();
+        /* Shared so a history decode can keep using it while the dataset is replaced */
+        std::shared_ptr<DataMatrix> m_dataMatrix = std::shared_ptr<DataMatrix>();
         Som m_som = Som(10, 10, 3);
+        Trainer m_trainer;
+        /* libsom's Som::train can not be stopped, its thread is joined on shutdown. The flag is raised before the thread starts. */
+        std::thread m_somTrainingThread;
+        std::atomic<bool> m_somTraining{false};
         bool showModelVectorsAsImage = false;
         int modelVectorAsImageWidth = 28;
         int modelVectorAsImageHeight = 28;
@@ -25,32 +80,156 @@ namespace VSOMExplorer
         size_t m_currentGreenColumnId = 0;
         size_t m_currentBlueColumnId = 0;
 
-        static int scaleColorToUCharRange(float value, float max, float min);
-        static int scaleColorToUCharRangeWithZoom(float value, float max, float min, int outMax, int outMin);
+        std::optional<PreviewData> m_previewData = std::optional<PreviewData>{};
+
+        int m_somWidth = 10;
+        int m_somHeight = 10;
+        float m_initSigma = 1.0f;
+        /* Fixed initialization seed, together with the deterministic trainer it makes runs reproducible */
+        int m_seed = 1;
+        TrainingParameters m_trainingParameters = TrainingParameters{};
+        ColorRange m_uMatrixRange = ColorRange{};
+        ColorRange m_weightMapRange = ColorRange{};
+        ColorRange m_bmuHitsRange = ColorRange{};
+
+        /* Workspace loading: the file itself is read immediately, the heavy parts on a background thread */
+        std::optional<Workspace> m_pendingWorkspace = std::optional<Workspace>{};
+        std::future<std::optional<Codebook>> m_modelFuture;
+        std::future<LoadedDataset> m_datasetFuture;
+        std::future<DerivedViews> m_derivedFuture;
+        std::thread m_workspaceThread;
+        size_t m_visibleModelWindows = 0;
+        size_t m_visibleDatasetWindows = 0;
+
+        /* Training history: a selected snapshot replaces the live model in the map windows until Live is pressed.
+           The selection is an epoch, snapshots are evicted from the front while training records new ones. */
+        TrainingHistory m_history;
+        std::future<HistoryFrame> m_historyFuture;
+        std::optional<size_t> m_historyEpoch = std::optional<size_t>{};
+        size_t m_historyShown = ModelViews::noGeneration;
+        /* A decode still running when the history is reset is dropped once it finishes */
+        size_t m_historyResets = 0;
+        size_t m_historyEpochBase = 0;
+        size_t m_lastRecordedEpoch = 0;
+        bool m_somWasTraining = false;
+
+        /* Steady state frames draw from these caches only, see RefreshViews */
+        size_t m_modelGeneration = 0;
+        size_t m_datasetGeneration = 0;
+        bool m_wasTraining = false;
+        /* While training the map windows follow the model at this pace instead of every frame */
+        static constexpr auto trainingRefreshInterval = std::chrono::milliseconds(250);
+        std::chrono::steady_clock::time_point m_lastTrainingRefresh = std::chrono::steady_clock::time_point{};
+        Codebook m_trainingSnapshot = Codebook{};
+        size_t m_trainingSnapshotVersion = 0;
+        ModelViews m_modelViews = ModelViews{};
+        DatasetViews m_datasetViews = DatasetViews{};
+        FrameArena m_frameArena;
+        size_t m_lastFrameHeapAllocations = 0;
+        size_t m_lastFrameImGuiAllocations = 0;
+
+        bool m_hexagonalTopology = false;
+        HexGeometry m_uMatrixHex;
+        HexGeometry m_weightMapHex;
+        HexGeometry m_bmuHitsHex;
+        HexGeometry m_mapHex;
+        HexGeometry m_sigmaHex;
+        HexGeometry m_labelHex;
+
+        /* Class statistics for the chosen label column, counted off the UI thread once per model revision */
+        long m_labelColumn = EpochSampler::noLabelColumn;
+        LabelMaps m_labelMaps = LabelMaps{};
+        std::future<LabelMaps> m_labelMapsFuture;
+        LabelLayer m_labelLayer = LabelLayer::Majority;
+        size_t m_labelClass = 0;
+        ColorRange m_labelRange = ColorRange{};
+
+        /* Nearest neurons and rows to a dataset row or a typed vector, searched off the UI thread.
+           The pool is created on the first query and outlives the future using it. */
+        std::unique_ptr<ThreadPool> m_queryPool = std::unique_ptr<ThreadPool>();
+        std::future<QueryResult> m_queryFuture;
+        QueryResult m_queryResult = QueryResult{};
+        bool m_queryByRow = true;
+        int m_queryRow = 0;
+        char m_queryVector[1024] = {};
+        int m_queryCount = 10;
+        std::string m_queryError = std::string{};
+
+        /* Derived caches the memory budget may drop, each rebuilds lazily on next use */
+        ComponentPlanes m_componentPlanes;
+        ComponentPlanes m_sigmaPlanes;
+        MemoryBudget m_memoryBudget;
+        size_t m_componentPlanesCache = 0;
+        size_t m_sigmaPlanesCache = 0;
+        size_t m_trainingMatrixCache = 0;
+        size_t m_previewCache = 0;
+        size_t m_hexCache = 0;
+        size_t m_labelMapsCache = 0;
+
+        /* Rebuilt only when the selection changes, the map windows look colors up every frame */
+        Colormap m_colormap = Colormap{};
+        bool m_bmuHitsLogScale = false;
+
         void RenderCombo(const char *name, const char *const *labels, const size_t numberOfChoices, size_t *currentId, const char *combo_preview_value);
-        void RenderCombo(const std::string &name, const std::vector<std::string> &labels, size_t *currentId, const std::string &combo_preview_value);
+        void RenderCombo(const char *name, const std::vector<const char *> &labels, size_t *currentId);
+        void RenderFeatureCombos();
+        bool hasValidFeatureSelection() const;
+        void DrawCells(const ImU32 *colors, size_t xSteps, size_t ySteps, const ImVec2 &p, float xStepSize, float yStepSize);
+        void DrawMap(HexGeometry &hex, const ImU32 *colors, size_t xSteps, size_t ySteps, const ImVec2 &size, size_t *hoverX, size_t *hoverY);
+        void DrawQueryHighlights(const HexGeometry &hex, size_t xSteps, size_t ySteps, const ImVec2 &origin, const ImVec2 &size);
+        void RenderValueGrid(const ValueGrid &grid, ColorRange &range, HexGeometry &hex, bool logScale = false);
+        const ImU32 *RgbColors(const Codebook &codebook, ComponentPlanes &planes, const std::vector<float> &featureMin, const std::vector<float> &featureMax);
+        void RegisterCaches();
+        void RefreshViews();
+        std::vector<float> getDatasetWeights();
+        size_t getSomDepth() const;
+        /* False when m_dataMatrix is the loader's own parsed matrix, already counted with the dataset */
+        bool ownsTrainingMatrix() const;
+        bool BeginWindow(const char *name, size_t *visibleCounter);
+        Workspace captureWorkspace() const;
+        void applyWorkspace(const Workspace &workspace);
+        void StartWorkspaceLoading();
+        void PollWorkspaceLoading();
+        void StartHistoryDecode(size_t epoch);
+        void PollHistory();
+        void ResetHistory();
+        void PollLabelMaps();
+        void StartQuery();
         void LoadMainMenu();
         void DatasetEditor();
         void DatasetViewer();
+        void QueryViewer();
         void RenderUMatrix();
         void RenderWeigthMap();
         void RenderBmuHits();
+        void LabelViewer();
         void RenderMap();
         void RenderSigmaMap();
         void SomHandler();
         void MetricsViewer();
+        void MemoryViewer();
+        void HistoryViewer();
         void SettingsPane();
 
     public:
         Handler() 
         {
-            m_som.randomInitialize((unsigned)(time(NULL)+clock()), 1);
+            m_som.randomInitialize(static_cast<unsigned>(m_seed), 1);
+            RegisterCaches();
+            m_trainer.setEpochCallback([this](size_t epoch, const Codebook &codebook)
+                                       { m_history.record(epoch, codebook); });
         };
         Handler(const Handler&) = delete;
         Handler& operator=(const Handler&) = delete;
-        ~Handler() = default;
+        ~Handler() { StopTraining(); }
 
         void RenderExplorer();
+        bool isWorkspaceLoading() const;
+        bool isTraining() const { return m_somTraining || m_som.isTraining() || m_trainer.isTraining(); }
+        /* Stops the in-app trainer after its current epoch and waits for the training and workspace loading threads */
+        void StopTraining();
         void SetDataset(std::unique_ptr<DataSet> dataset);
+        bool OpenWorkspace(const std::string &path);
+        bool SaveWorkspace(const std::string &path) const;
     };
 }
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    /* Bump allocator for scratch data that lives for one frame.
+       Blocks are kept across reset(), so once the largest frame has been seen no more heap allocations are made. */
+    class FrameArena
+    {
+    private:
+        struct Block
+        {
+            std::unique_ptr<std::byte[]> data;
+            size_t capacity;
+        };
+
+        static constexpr size_t defaultBlockSize = 64 * 1024;
+
+        std::vector<Block> m_blocks = std::vector<Block>{};
+        size_t m_currentBlock{0};
+        size_t m_offset{0};
+
+        void *allocateBytes(size_t bytes, size_t alignment);
+
+    public:
+        FrameArena() = default;
+        FrameArena(const FrameArena &) = delete;
+        FrameArena &operator=(const FrameArena &) = delete;
+
+        void reset();
+
+        template <typename T>
+        T *allocate(size_t count)
+        {
+            return static_cast<T *>(allocateBytes(sizeof(T) * count, alignof(T)));
+        }
+
+        size_t capacity() const;
+    };
+}
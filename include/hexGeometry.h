@@ -0,0 +1,45 @@
+#pragma once
+
+#include <imgui/imgui.h>
+
+#include <vector>
+
+namespace VSOMExplorer
+{
+    /* Pointy-top hexagonal cells in odd-r offset layout (odd rows shifted half a cell right).
+       Vertex positions are built once per map size and viewport, colors only when they change,
+       so a frame is a straight copy into the draw list. */
+    class HexGeometry
+    {
+    private:
+        static constexpr size_t verticesPerCell = 6;
+        static constexpr size_t indicesPerCell = 12;
+        /* Largest batch that stays inside one 16-bit index range */
+        static constexpr size_t cellsPerBatch = 65535 / verticesPerCell;
+
+        size_t m_columns{0};
+        size_t m_rows{0};
+        ImVec2 m_viewport = ImVec2(0.f, 0.f);
+        float m_radius{0.f};
+
+        std::vector<ImDrawVert> m_vertices = std::vector<ImDrawVert>{};
+        std::vector<ImU32> m_colors = std::vector<ImU32>{};
+
+        void rebuild();
+
+    public:
+        /* Returns true if the geometry had to be rebuilt */
+        bool update(size_t columns, size_t rows, const ImVec2 &viewport);
+        void setColors(const ImU32 *colors);
+        void draw(ImDrawList *drawList, const ImVec2 &origin) const;
+        /* Border of one cell, drawn on top of the map */
+        void outline(ImDrawList *drawList, const ImVec2 &origin, size_t column, size_t row, ImU32 color, float thickness) const;
+
+        /* Cell under a position relative to the draw origin, O(1) via axial coordinates */
+        bool hitTest(const ImVec2 &position, size_t *column, size_t *row) const;
+
+        /* Frees the cached vertices, the next update rebuilds them */
+        void clear();
+        size_t memoryBytes() const { return m_vertices.capacity() * sizeof(ImDrawVert) + m_colors.capacity() * sizeof(ImU32); }
+    };
+}
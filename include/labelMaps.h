@@ -0,0 +1,60 @@
+#pragma once
+
+#include "bmuSearch.h"
+#include "codebook.h"
+#include "dataMatrix.h"
+#include "viewCache.h"
+
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    enum class LabelLayer
+    {
+        Majority,
+        Purity,
+        Entropy,
+        ClassHits
+    };
+
+    inline constexpr const char *labelLayerNames[] = {"Majority label", "Purity", "Entropy", "Class hits"};
+    inline constexpr size_t labelLayerCount = sizeof(labelLayerNames) / sizeof(labelLayerNames[0]);
+
+    /* Class make-up of every neuron for one label column, valid for one model revision and dataset generation */
+    struct LabelMaps
+    {
+        static constexpr size_t maxClasses = 256;
+        static constexpr size_t noClass = std::numeric_limits<size_t>::max();
+
+        size_t revision{ModelViews::noGeneration};
+        size_t datasetGeneration{ModelViews::noGeneration};
+        size_t labelColumn{0};
+        /* Dataset weights the BMUs were found with */
+        std::vector<float> weights = std::vector<float>{};
+
+        /* Distinct label values in ascending order, a class is an index into these */
+        std::vector<float> classes = std::vector<float>{};
+        std::vector<std::string> classNames = std::vector<std::string>{};
+        std::vector<const char *> classLabels = std::vector<const char *>{};
+        bool tooManyClasses{false};
+        /* Rows whose label is not a number are left out */
+        size_t unlabelledRows{0};
+
+        std::vector<ValueGrid> classHits = std::vector<ValueGrid>{};
+        /* noClass for neurons no row maps to */
+        std::vector<size_t> majority = std::vector<size_t>{};
+        ValueGrid purity = ValueGrid{};
+        ValueGrid entropy = ValueGrid{};
+
+        bool matches(size_t currentRevision, size_t currentDatasetGeneration, size_t currentLabelColumn) const;
+        /* classLabels point into classNames, rebuild them after the maps have been moved */
+        void updateLabels();
+        size_t memoryBytes() const;
+    };
+
+    /* One parallel pass over the rows. Every worker counts into its own sparse (neuron, label) table,
+       the tables are merged once all rows are counted. */
+    LabelMaps computeLabelMaps(const Codebook &codebook, const DataMatrix &data, const std::vector<float> &weights, BmuSearchMode mode, size_t labelColumn, size_t threads = 0);
+}
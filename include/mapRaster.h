@@ -0,0 +1,50 @@
+#pragma once
+
+#include "bmuSearch.h"
+#include "codebook.h"
+#include "colormap.h"
+#include "dataMatrix.h"
+#include "pngWriter.h"
+#include "viewCache.h"
+#include "workspace.h"
+
+#include <string>
+#include <vector>
+
+/* Renderer independent versions of the map windows, used for batch image export */
+namespace VSOMExplorer::MapRaster
+{
+    enum class Layer
+    {
+        UMatrix,
+        BmuHits,
+        ComponentPlane,
+        FeatureRgb
+    };
+
+    struct View
+    {
+        Layer layer{Layer::UMatrix};
+        std::string name = std::string{};
+        size_t feature{0};
+        size_t redColumnId{0};
+        size_t greenColumnId{0};
+        size_t blueColumnId{0};
+        ColorRange range = ColorRange{};
+        /* Single value layers only, the RGB view scales each feature linearly */
+        ColormapName colormap{ColormapName::Grayscale};
+        size_t colormapEntries{Colormap::coarseEntries};
+        bool logScale{false};
+    };
+
+    /* Mean distance from each neuron to its four grid neighbours */
+    ValueGrid computeUMatrix(const Codebook &codebook);
+    ValueGrid computeBmuHits(const Codebook &codebook, const DataMatrix &data, const std::vector<float> &weights, BmuSearchMode mode);
+    ValueGrid componentPlane(const Codebook &codebook, size_t feature);
+
+    /* hits may be null when no BmuHits view is requested */
+    Image rasterize(const Codebook &codebook, const ValueGrid *hits, const View &view, size_t width, size_t height);
+
+    /* One task per view on a pool of threads workers, 0 for one per hardware thread */
+    std::vector<Image> rasterizeAll(const Codebook &codebook, const ValueGrid *hits, const std::vector<View> &views, size_t width, size_t height, size_t threads = 0);
+}
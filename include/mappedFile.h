@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace VSOMExplorer
+{
+    /* Read-only view of a whole file through the OS page cache, nothing is copied until it is read */
+    class MappedFile
+    {
+    private:
+        const char *m_data{nullptr};
+        size_t m_size{0};
+#ifdef _WIN32
+        void *m_file{nullptr};
+        void *m_mapping{nullptr};
+#endif
+
+        void close();
+
+    public:
+        MappedFile() = default;
+        /* Empty or unreadable files leave the mapping closed */
+        explicit MappedFile(const std::string &path);
+        MappedFile(MappedFile &&other) noexcept;
+        MappedFile &operator=(MappedFile &&other) noexcept;
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        ~MappedFile() { close(); }
+
+        bool isOpen() const { return m_data != nullptr; }
+        const char *data() const { return m_data; }
+        size_t size() const { return m_size; }
+    };
+}
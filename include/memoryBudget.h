@@ -0,0 +1,46 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    /* Byte accounting for caches that can be rebuilt from the dataset or the model.
+       Caches are touched when used, and when their total exceeds the budget the least recently
+       used ones are dropped first. A cache touched in the current frame is never dropped, so a
+       budget smaller than one frame's working set can not make the explorer rebuild every frame. */
+    class MemoryBudget
+    {
+    public:
+        static constexpr size_t unlimited = 0;
+
+        struct Cache
+        {
+            std::string name = std::string{};
+            std::function<size_t()> bytes = std::function<size_t()>{};
+            /* Drops the cache, returns false while it is in use elsewhere */
+            std::function<bool()> evict = std::function<bool()>{};
+            size_t lastUse{0};
+            size_t lastEvictionAttempt{0};
+            size_t evictions{0};
+        };
+
+        size_t add(std::string name, std::function<size_t()> bytes, std::function<bool()> evict);
+        void touch(size_t id) { m_caches[id].lastUse = m_frame; }
+
+        /* Ends the frame, evicting in LRU order until the caches fit */
+        void enforce();
+
+        size_t getBudget() const { return m_budget; }
+        void setBudget(size_t bytes) { m_budget = bytes; }
+        size_t getFrame() const { return m_frame; }
+        size_t totalBytes() const;
+        const std::vector<Cache> &getCaches() const { return m_caches; }
+
+    private:
+        std::vector<Cache> m_caches = std::vector<Cache>{};
+        size_t m_budget{unlimited};
+        size_t m_frame{1};
+    };
+}
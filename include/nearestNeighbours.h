@@ -0,0 +1,23 @@
+#pragma once
+
+#include "threadPool.h"
+
+#include <limits>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    struct Neighbour
+    {
+        size_t index{0};
+        float distance{0.f};
+    };
+
+    inline constexpr size_t noExcludedIndex = std::numeric_limits<size_t>::max();
+
+    /* The k of count packed vectors closest to the query under the weighted distance, nearest first,
+       ties going to the lower index. Every task keeps a bounded max-heap of its best candidates, so a
+       vector only costs a heap operation when it beats the task's current k-th best. */
+    std::vector<Neighbour> nearestNeighbours(ThreadPool &pool, const float *query, const float *vectors, size_t count, size_t depth,
+                                             const std::vector<float> &weights, size_t k, size_t excludedIndex = noExcludedIndex);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    /* 8-bit RGBA image, row-major */
+    struct Image
+    {
+        size_t width{0};
+        size_t height{0};
+        std::vector<uint8_t> pixels = std::vector<uint8_t>{};
+
+        uint8_t *pixel(size_t x, size_t y) { return pixels.data() + (y * width + x) * 4; }
+    };
+
+    /* Self contained PNG encoder (deflate with fixed Huffman codes), no zlib or SDL needed */
+    std::vector<uint8_t> encodePng(const Image &image);
+    bool writePng(const std::string &path, const Image &image);
+}
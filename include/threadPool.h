@@ -0,0 +1,64 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    /* Work-stealing pool for data parallel loops. Each worker gets a contiguous share of the
+       task indices and steals from the back of the other queues once its own runs dry.
+       Tasks must not depend on which thread runs them, callers reduce results in index order. */
+    class ThreadPool
+    {
+    private:
+        /* The task travels with its index so a worker still draining an old batch never
+           runs a new index with the old function */
+        struct Task
+        {
+            const std::function<void(size_t)> *function;
+            size_t index;
+        };
+
+        struct Queue
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        std::vector<std::thread> m_workers = std::vector<std::thread>{};
+        std::vector<std::unique_ptr<Queue>> m_queues = std::vector<std::unique_ptr<Queue>>{};
+
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+        size_t m_remaining{0};
+        size_t m_batch{0};
+        bool m_stop{false};
+        std::exception_ptr m_error = nullptr;
+        double m_busySeconds{0};
+
+        void workerLoop(size_t id);
+        bool takeTask(size_t id, Task *task);
+
+    public:
+        /* threads <= 1 runs everything on the calling thread */
+        explicit ThreadPool(size_t threads);
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+        ~ThreadPool();
+
+        size_t size() const { return m_workers.empty() ? 1 : m_workers.size(); }
+
+        /* Runs task(i) for every i in [0, count) and blocks until all are done */
+        void parallelFor(size_t count, const std::function<void(size_t)> &task);
+
+        /* Summed time spent inside tasks since the last call */
+        double takeBusySeconds();
+    };
+}
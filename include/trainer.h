@@ -0,0 +1,120 @@
+#pragma once
+
+#include "bmuSearch.h"
+#include "codebook.h"
+#include "dataMatrix.h"
+#include "epochSampler.h"
+#include "threadPool.h"
+
+#include <libsom/SOM.hpp>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    struct TrainingParameters
+    {
+        size_t numberOfEpochs{100};
+        double eta0{0.9};
+        double etaDecay{0.01};
+        double sigma0{10};
+        double sigmaDecay{0.01};
+        Som::WeigthDecayFunction decayFunction{Som::WeigthDecayFunction::Exponential};
+        BmuSearchMode searchMode{BmuSearchMode::Exhaustive};
+        /* Batch Map epochs are split across this many workers, online epochs stay sequential */
+        size_t threads{1};
+
+        /* Rows per epoch, stratified on labelColumn when one is set */
+        EpochSampling sampling{EpochSampling::Full};
+        double sampleFraction{0.1};
+        size_t sampleSize{10000};
+        long labelColumn{EpochSampler::noLabelColumn};
+        /* One more epoch over every row after the sampled ones */
+        bool finalFullPass{true};
+        unsigned seed{1};
+    };
+
+    /* libsom's Som::train covers sequential exhaustive training, everything else needs the in-app trainer */
+    inline bool needsInAppTrainer(const TrainingParameters &parameters)
+    {
+        return parameters.searchMode != BmuSearchMode::Exhaustive || parameters.threads > 1 || parameters.sampling != EpochSampling::Full;
+    }
+
+    struct TrainerMetrics
+    {
+        std::vector<float> MeanSquaredError = std::vector<float>{};
+        std::vector<float> BmuRecall = std::vector<float>{};
+        std::vector<float> EpochSeconds = std::vector<float>{};
+        /* Time spent in worker tasks over wall time, 1 when sequential */
+        std::vector<float> Speedup = std::vector<float>{};
+        size_t Threads{1};
+        size_t LastEpochRows{0};
+        size_t Rows{0};
+    };
+
+    /* In-app training loop used when an accelerated BMU search or parallel training is selected.
+       Mirrors Som::train and writes the codebook back into the Som after every epoch. start runs it on
+       a thread the trainer owns, which keeps its own reference to the data.
+       Batch Map epochs work on fixed size chunks and reduce them in chunk order, so the result
+       for a given initial codebook is bit-identical whatever the thread count. */
+    class Trainer
+    {
+    private:
+        static constexpr size_t verificationInterval = 64;
+        static constexpr size_t rowsPerTask = 1024;
+        static constexpr size_t neuronsPerTask = 64;
+
+        std::atomic<bool> m_training{false};
+        std::atomic<bool> m_stopRequested{false};
+        std::thread m_thread;
+        TrainerMetrics m_metrics = TrainerMetrics{};
+        std::function<void(size_t, const Codebook &)> m_epochCallback = std::function<void(size_t, const Codebook &)>{};
+
+        /* Copy of the codebook after the latest epoch, so the UI never reads the Som being trained */
+        mutable std::mutex m_snapshotMutex;
+        Codebook m_snapshot = Codebook{};
+        size_t m_snapshotVersion{0};
+
+        void publish(const Codebook &codebook);
+
+        static double neighbourhood(size_t a, size_t b, size_t width, double sigma);
+        static double onlineEta(const TrainingParameters &parameters, size_t epoch);
+
+        static double onlineEpoch(Codebook &codebook, BmuSearch &search, const DataMatrix &data,
+                                  const std::vector<size_t> &rows, std::vector<size_t> &previousBmus,
+                                  double eta, double sigma, size_t epoch);
+        static double batchEpoch(Codebook &codebook, BmuSearch &search, const DataMatrix &data,
+                                 const std::vector<size_t> &rows, std::vector<size_t> &previousBmus,
+                                 double sigma, size_t epoch, ThreadPool &pool);
+
+    public:
+        std::mutex metricsMutex;
+
+        Trainer() = default;
+        Trainer(const Trainer &) = delete;
+        Trainer &operator=(const Trainer &) = delete;
+        ~Trainer() { stop(); }
+
+        /* Blocking, the data is kept alive until the last epoch is done */
+        void train(Som &som, std::shared_ptr<const DataMatrix> data, std::vector<float> weights, TrainingParameters parameters);
+
+        /* isTraining is true as soon as this returns, false if a run is still going */
+        bool start(Som &som, std::shared_ptr<const DataMatrix> data, std::vector<float> weights, TrainingParameters parameters);
+        /* Ends training after the current epoch and waits for the thread, the Som keeps the last finished epoch */
+        void stop();
+
+        /* Called on the training thread with the number of completed epochs, 0 before the first */
+        void setEpochCallback(std::function<void(size_t, const Codebook &)> callback) { m_epochCallback = std::move(callback); }
+
+        /* Copies the latest published codebook into target if it is newer than version, reusing target's storage */
+        bool takeSnapshot(Codebook &target, size_t &version) const;
+
+        bool isTraining() const { return m_training; }
+        const TrainerMetrics &getMetrics() const { return m_metrics; }
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "codebook.h"
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    /* Bounded ring of codebook snapshots taken while training.
+       Each snapshot stores the XOR of its float bits with the previous one, split into byte planes
+       and zero-run encoded, which is lossless and small since late epochs barely move the map.
+       Every keyframeInterval snapshots, and always at the front of the ring, a snapshot is stored
+       against zeros so a decode never walks more than one keyframe interval.
+       Safe to record from the training thread while another thread decodes. */
+    class TrainingHistory
+    {
+    public:
+        static constexpr size_t keyframeInterval = 16;
+
+        void setInterval(size_t epochs);
+        void setMemoryCap(size_t bytes);
+        void setEnabled(bool enabled);
+
+        size_t getInterval() const;
+        size_t getMemoryCap() const;
+        bool isEnabled() const;
+
+        /* Epoch counts completed epochs, 0 is the map before training. Skipped unless on the interval
+           or the last epoch of a run. */
+        void record(size_t epoch, const Codebook &codebook, bool last = false);
+        void clear();
+
+        size_t size() const;
+        size_t epochAt(size_t index) const;
+        /* Index of the snapshot taken at epoch, or of the next one once it has been evicted */
+        size_t indexOf(size_t epoch) const;
+        size_t memoryBytes() const;
+        size_t rawBytes() const;
+
+        /* By epoch rather than index, eviction shifts the indices under a reader */
+        std::optional<Codebook> decode(size_t epoch) const;
+
+    private:
+        struct Snapshot
+        {
+            size_t epoch{0};
+            bool keyframe{false};
+            std::vector<uint8_t> data = std::vector<uint8_t>{};
+        };
+
+        mutable std::mutex m_mutex;
+        bool m_enabled{true};
+        size_t m_interval{1};
+        size_t m_memoryCap{64 * 1024 * 1024};
+
+        size_t m_width{0};
+        size_t m_height{0};
+        size_t m_depth{0};
+        std::deque<Snapshot> m_snapshots = std::deque<Snapshot>{};
+        /* Bits of the latest snapshot, the base of the next delta */
+        std::vector<uint32_t> m_previous = std::vector<uint32_t>{};
+        size_t m_sinceKeyframe{0};
+        size_t m_bytes{0};
+        /* Counts clears, a record or trim that dropped the lock to encode gives up when it changed */
+        size_t m_resets{0};
+
+        size_t usedBytes() const { return m_bytes + m_previous.capacity() * sizeof(uint32_t); }
+        /* Evicts from the front down to the memory cap, may release the lock while encoding */
+        void trim(std::unique_lock<std::mutex> &lock);
+        size_t findEpoch(size_t epoch) const;
+        void decodeInto(size_t index, std::vector<uint32_t> &bits) const;
+    };
+}
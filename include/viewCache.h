@@ -0,0 +1,120 @@
+#pragma once
+
+#include "codebook.h"
+#include "colormap.h"
+
+#include <libsom/SOM.hpp>
+#include <libsom/DataSet.hpp>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace VSOMExplorer
+{
+    /* Flat grid of values with its maximum, what the map windows draw from */
+    struct ValueGrid
+    {
+        size_t width{0};
+        size_t height{0};
+        float minValue{0.f};
+        float maxValue{0.f};
+        std::vector<float> values = std::vector<float>{};
+
+        float at(size_t x, size_t y) const { return values[y * width + x]; }
+        size_t memoryBytes() const { return values.capacity() * sizeof(float); }
+    };
+
+    /* Everything the map windows read from the Som, refreshed only when the model generation changes */
+    struct ModelViews
+    {
+        static constexpr size_t noGeneration = std::numeric_limits<size_t>::max();
+
+        size_t generation{noGeneration};
+        /* Counts every refresh, the generation stays the same while training */
+        size_t revision{0};
+
+        Codebook codebook = Codebook{};
+        Codebook sigma = Codebook{};
+        ValueGrid uMatrix = ValueGrid{};
+        ValueGrid weightMap = ValueGrid{};
+        ValueGrid bmuHits = ValueGrid{};
+
+        std::vector<float> featureMin = std::vector<float>{};
+        std::vector<float> featureMax = std::vector<float>{};
+        std::vector<float> sigmaMin = std::vector<float>{};
+        std::vector<float> sigmaMax = std::vector<float>{};
+
+        void refresh(const Som &som, size_t newGeneration);
+        /* Shows a recorded codebook, sigma and weight map stay those of the live model. Empty hits keep the live ones. */
+        void showSnapshot(Codebook snapshot, ValueGrid snapshotUMatrix, ValueGrid snapshotHits);
+        /* Shows the trainer's latest codebook, copied into the storage already held */
+        void showTraining(const Codebook &snapshot, ValueGrid snapshotUMatrix);
+    };
+
+    /* Strings derived from the dataset, kept so that no frame has to build them */
+    struct DatasetViews
+    {
+        size_t generation{ModelViews::noGeneration};
+
+        std::vector<std::string> names = std::vector<std::string>{};
+        std::vector<const char *> labels = std::vector<const char *>{};
+        std::vector<std::string> weightLabels = std::vector<std::string>{};
+
+        /* Preformatted preview table, zero terminated cells packed into one buffer */
+        bool hasPreviewText{false};
+        size_t previewRows{0};
+        size_t previewColumns{0};
+        std::vector<char> previewText = std::vector<char>{};
+        std::vector<size_t> previewOffsets = std::vector<size_t>{};
+
+        void refresh(DataSet &dataset, size_t newGeneration);
+
+        template <typename Rows>
+        void formatPreview(const Rows &rows, size_t numberOfRows, size_t numberOfColumns);
+
+        const char *previewCell(size_t row, size_t column) const { return previewText.data() + previewOffsets[row * previewColumns + column]; }
+
+        void clearPreview();
+        size_t previewBytes() const { return previewText.capacity() + previewOffsets.capacity() * sizeof(size_t); }
+    };
+
+    /* Features of a codebook scaled to bytes, built on first use and valid for one model revision */
+    class ComponentPlanes
+    {
+    private:
+        size_t m_revision{ModelViews::noGeneration};
+        /* Empty planes are not built, capacity is kept across revisions so training does not reallocate */
+        std::vector<std::vector<uint8_t>> m_planes = std::vector<std::vector<uint8_t>>{};
+        std::vector<float> m_scratch = std::vector<float>{};
+
+    public:
+        const uint8_t *get(const Codebook &codebook, size_t revision, size_t feature, float min, float max);
+
+        void clear();
+        size_t memoryBytes() const;
+    };
+
+    template <typename Rows>
+    void DatasetViews::formatPreview(const Rows &rows, size_t numberOfRows, size_t numberOfColumns)
+    {
+        previewRows = numberOfRows;
+        previewColumns = numberOfColumns;
+        previewText.clear();
+        previewOffsets.clear();
+        previewOffsets.reserve(numberOfRows * numberOfColumns);
+
+        for (size_t row{0}; row < numberOfRows; ++row)
+        {
+            for (size_t column{0}; column < numberOfColumns; ++column)
+            {
+                const auto text = std::to_string(rows[row][column]);
+                previewOffsets.push_back(previewText.size());
+                previewText.insert(previewText.end(), text.begin(), text.end());
+                previewText.push_back('\0');
+            }
+        }
+
+        hasPreviewText = true;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "colormap.h"
+#include "trainer.h"
+
+#include <optional>
+#include <string>
+
+namespace VSOMExplorer
+{
+    /* Everything needed to bring the explorer back to where it was left.
+       Stored as a plain key=value text file, the model itself goes in a separate checkpoint file. */
+    struct Workspace
+    {
+        std::string datasetPath = std::string{};
+        std::string modelPath = std::string{};
+
+        int somWidth{10};
+        int somHeight{10};
+        float initSigma{1.0f};
+        int seed{1};
+        TrainingParameters training = TrainingParameters{};
+
+        size_t redColumnId{0};
+        size_t greenColumnId{0};
+        size_t blueColumnId{0};
+
+        ColorRange uMatrixRange = ColorRange{};
+        ColorRange weightMapRange = ColorRange{};
+        ColorRange bmuHitsRange = ColorRange{};
+        ColormapName colormap{ColormapName::Grayscale};
+        size_t colormapEntries{Colormap::coarseEntries};
+        bool bmuHitsLogScale{false};
+        size_t cacheBudgetMegabytes{0};
+        bool historyEnabled{true};
+        size_t historyInterval{1};
+        size_t historyMemoryCapMegabytes{64};
+        long labelMapColumn{EpochSampler::noLabelColumn};
+
+        bool showModelVectorsAsImage{false};
+        int modelVectorAsImageWidth{28};
+        int modelVectorAsImageHeight{28};
+        bool hexagonalTopology{false};
+
+        bool save(const std::string &path) const;
+        static std::optional<Workspace> load(const std::string &path);
+
+        static std::string modelPathFor(const std::string &workspacePath) { return workspacePath + ".model"; }
+    };
+}
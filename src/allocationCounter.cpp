@@ -0,0 +1,82 @@
+#include "allocationCounter.h"
+
+#include <imgui/imgui.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<size_t> heapAllocationCount{0};
+    std::atomic<size_t> imGuiAllocationCount{0};
+
+#ifdef VSOM_COUNT_ALLOCATIONS
+    void *countedImGuiAlloc(size_t size, void *)
+    {
+        ++imGuiAllocationCount;
+        return std::malloc(size);
+    }
+
+    void countedImGuiFree(void *ptr, void *)
+    {
+        std::free(ptr);
+    }
+#endif
+}
+
+#ifdef VSOM_COUNT_ALLOCATIONS
+void *operator new(size_t size)
+{
+    ++heapAllocationCount;
+    if (auto *ptr = std::malloc(size > 0 ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc{};
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+#endif
+
+namespace VSOMExplorer::AllocationCounter
+{
+    void installImGuiAllocator()
+    {
+#ifdef VSOM_COUNT_ALLOCATIONS
+        ImGui::SetAllocatorFunctions(countedImGuiAlloc, countedImGuiFree);
+#endif
+    }
+
+    size_t heapAllocations()
+    {
+        return heapAllocationCount;
+    }
+
+    size_t imGuiAllocations()
+    {
+        return imGuiAllocationCount;
+    }
+}
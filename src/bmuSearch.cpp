@@ -0,0 +1,238 @@
+#include "bmuSearch.h"
+#include "distance.h"
+
+#include <algorithm>
+#include <array>
+
+namespace VSOMExplorer
+{
+    BmuSearch::BmuSearch(const Codebook &codebook, const std::vector<float> &weights, BmuSearchMode mode)
+        : m_codebook{codebook}, m_weights{weights}, m_mode{mode}
+    {
+        rebuild();
+    }
+
+    void BmuSearch::rebuild()
+    {
+        m_levels.clear();
+        if (m_mode == BmuSearchMode::Exhaustive)
+            return;
+
+        const auto depth = m_codebook.getDepth();
+        auto width = m_codebook.getWidth();
+        auto height = m_codebook.getHeight();
+
+        while (width > coarsestSize || height > coarsestSize)
+        {
+            auto level = Level{};
+            level.width = (width + 1) / 2;
+            level.height = (height + 1) / 2;
+            level.values.assign(level.width * level.height * depth, 0.f);
+
+            const auto *finer = m_levels.empty() ? nullptr : &m_levels.back();
+
+            for (size_t y{0}; y < level.height; ++y)
+            {
+                for (size_t x{0}; x < level.width; ++x)
+                {
+                    auto *destination = level.values.data() + (y * level.width + x) * depth;
+                    size_t count{0};
+
+                    for (size_t fy{2 * y}; fy < std::min(2 * y + 2, height); ++fy)
+                    {
+                        for (size_t fx{2 * x}; fx < std::min(2 * x + 2, width); ++fx)
+                        {
+                            const auto *source = finer ? finer->getNeuron(fx, fy, depth) : m_codebook.getNeuron(m_codebook.getIndex(fx, fy));
+                            for (size_t i{0}; i < depth; ++i)
+                                destination[i] += source[i];
+                            ++count;
+                        }
+                    }
+
+                    for (size_t i{0}; i < depth; ++i)
+                        destination[i] /= static_cast<float>(count);
+                }
+            }
+
+            width = level.width;
+            height = level.height;
+            m_levels.push_back(std::move(level));
+        }
+    }
+
+    float BmuSearch::distance(const float *sample, size_t neuron) const
+    {
+        return weightedSquaredDistance(sample, m_codebook.getNeuron(neuron), m_weights.data(), m_codebook.getDepth());
+    }
+
+    size_t BmuSearch::findExhaustive(const float *sample) const
+    {
+        size_t best{0};
+        auto bestDistance = std::numeric_limits<float>::max();
+
+        for (size_t index{0}; index < m_codebook.size(); ++index)
+        {
+            const auto currentDistance = distance(sample, index);
+            if (currentDistance < bestDistance)
+            {
+                bestDistance = currentDistance;
+                best = index;
+            }
+        }
+
+        return best;
+    }
+
+    size_t BmuSearch::findHierarchical(const float *sample) const
+    {
+        if (m_levels.empty())
+            return findExhaustive(sample);
+
+        const auto depth = m_codebook.getDepth();
+        const auto *weights = m_weights.data();
+
+        /* Runs per sample on every training worker, so the beam and the candidates live on the stack */
+        auto beam = std::array<Candidate, beamWidth>{};
+        size_t beamSize{0};
+        auto keepBest = [&beam, &beamSize](const Candidate &candidate)
+        {
+            /* Sorted insertion, ties keep the candidate seen first */
+            auto position = beamSize;
+            while (position > 0 && candidate.distance < beam[position - 1].distance)
+                --position;
+            if (position == beamWidth)
+                return;
+
+            beamSize = std::min(beamSize + 1, beamWidth);
+            for (auto slot = beamSize - 1; slot > position; --slot)
+                beam[slot] = beam[slot - 1];
+            beam[position] = candidate;
+        };
+
+        /* Exhaustive scan of the coarsest level, at most coarsestSize squared neurons */
+        const auto &coarsest = m_levels.back();
+        for (size_t y{0}; y < coarsest.height; ++y)
+            for (size_t x{0}; x < coarsest.width; ++x)
+                keepBest(Candidate{weightedSquaredDistance(sample, coarsest.getNeuron(x, y, depth), weights, depth), x, y});
+
+        /* Refine each beam candidate in a 4x4 window on the next finer level, one cell margin around its children.
+           Overlapping windows are merged by sorting the cell indices. */
+        auto cells = std::array<size_t, beamWidth * windowCells>{};
+        for (size_t levelIndex = m_levels.size(); levelIndex-- > 0;)
+        {
+            const bool isFinest = levelIndex == 0;
+            const auto fineWidth = isFinest ? m_codebook.getWidth() : m_levels[levelIndex - 1].width;
+            const auto fineHeight = isFinest ? m_codebook.getHeight() : m_levels[levelIndex - 1].height;
+
+            size_t cellCount{0};
+            for (size_t candidate{0}; candidate < beamSize; ++candidate)
+            {
+                const auto &coarse = beam[candidate];
+                const size_t xBegin = coarse.x * 2 > 0 ? coarse.x * 2 - 1 : 0;
+                const size_t yBegin = coarse.y * 2 > 0 ? coarse.y * 2 - 1 : 0;
+                const size_t xEnd = std::min(coarse.x * 2 + 3, fineWidth);
+                const size_t yEnd = std::min(coarse.y * 2 + 3, fineHeight);
+
+                for (size_t y{yBegin}; y < yEnd; ++y)
+                    for (size_t x{xBegin}; x < xEnd; ++x)
+                        cells[cellCount++] = y * fineWidth + x;
+            }
+            std::sort(cells.begin(), cells.begin() + static_cast<std::ptrdiff_t>(cellCount));
+            cellCount = static_cast<size_t>(std::unique(cells.begin(), cells.begin() + static_cast<std::ptrdiff_t>(cellCount)) - cells.begin());
+
+            beamSize = 0;
+            for (size_t cell{0}; cell < cellCount; ++cell)
+            {
+                const auto x = cells[cell] % fineWidth;
+                const auto y = cells[cell] / fineWidth;
+                const auto *neuron = isFinest ? m_codebook.getNeuron(m_codebook.getIndex(x, y)) : m_levels[levelIndex - 1].getNeuron(x, y, depth);
+                keepBest(Candidate{weightedSquaredDistance(sample, neuron, weights, depth), x, y});
+            }
+        }
+
+        return m_codebook.getIndex(beam.front().x, beam.front().y);
+    }
+
+    size_t BmuSearch::findLocal(const float *sample, size_t start) const
+    {
+        const auto width = m_codebook.getWidth();
+        const auto height = m_codebook.getHeight();
+
+        auto current = start;
+        auto currentDistance = distance(sample, current);
+
+        /* Steepest descent over the 8-neighbourhood until no neighbour is closer */
+        for (size_t step{0}; step < maxLocalSteps; ++step)
+        {
+            const auto x = current % width;
+            const auto y = current / width;
+            auto best = current;
+            auto bestDistance = currentDistance;
+
+            for (size_t ny = y > 0 ? y - 1 : 0; ny < std::min(y + 2, height); ++ny)
+            {
+                for (size_t nx = x > 0 ? x - 1 : 0; nx < std::min(x + 2, width); ++nx)
+                {
+                    const auto neighbour = m_codebook.getIndex(nx, ny);
+                    if (neighbour == current)
+                        continue;
+
+                    const auto neighbourDistance = distance(sample, neighbour);
+                    if (neighbourDistance < bestDistance)
+                    {
+                        bestDistance = neighbourDistance;
+                        best = neighbour;
+                    }
+                }
+            }
+
+            if (best == current)
+                break;
+
+            current = best;
+            currentDistance = bestDistance;
+        }
+
+        return current;
+    }
+
+    size_t BmuSearch::find(const float *sample, size_t previousBmu, bool verify)
+    {
+        size_t bmu;
+        switch (m_mode)
+        {
+        case BmuSearchMode::Hierarchical:
+            bmu = findHierarchical(sample);
+            break;
+        case BmuSearchMode::Local:
+            bmu = previousBmu < m_codebook.size() ? findLocal(sample, previousBmu) : findHierarchical(sample);
+            break;
+        case BmuSearchMode::Exhaustive:
+        default:
+            return findExhaustive(sample);
+        }
+
+        if (!verify)
+            return bmu;
+
+        /* Exact fallback check, the approximate answer counts as a hit if it is equally close */
+        const auto exact = findExhaustive(sample);
+        ++m_verified;
+        if (exact == bmu || distance(sample, bmu) <= distance(sample, exact))
+            ++m_verifiedHits;
+
+        return exact;
+    }
+
+    float BmuSearch::getRecall() const
+    {
+        const auto verified = m_verified.load();
+        return verified > 0 ? static_cast<float>(m_verifiedHits.load()) / static_cast<float>(verified) : 1.f;
+    }
+
+    void BmuSearch::resetRecall()
+    {
+        m_verified = 0;
+        m_verifiedHits = 0;
+    }
+}
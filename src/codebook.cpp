@@ -0,0 +1,104 @@
+#include "codebook.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+
+namespace VSOMExplorer
+{
+    Codebook::Codebook(size_t width, size_t height, size_t depth)
+        : m_width{width}, m_height{height}, m_depth{depth}, m_values(width * height * depth, 0.f)
+    {
+    }
+
+    template <typename Getter>
+    Codebook Codebook::copyFromSom(const Som &som, Getter getNeuron)
+    {
+        const auto width = som.getWidth();
+        const auto height = som.getHeight();
+        const size_t depth = width * height > 0 ? static_cast<size_t>(som.getNeuron(size_t{0}).size()) : 0;
+
+        auto codebook = Codebook(width, height, depth);
+
+        for (size_t yIndex{0}; yIndex < height; ++yIndex)
+        {
+            for (size_t xIndex{0}; xIndex < width; ++xIndex)
+            {
+                const auto neuron = getNeuron(SomIndex{xIndex, yIndex});
+                auto *destination = codebook.getNeuron(codebook.getIndex(xIndex, yIndex));
+
+                for (size_t i{0}; i < depth; ++i)
+                    destination[i] = neuron[i];
+            }
+        }
+
+        return codebook;
+    }
+
+    Codebook Codebook::fromSom(const Som &som)
+    {
+        return copyFromSom(som, [&som](SomIndex index)
+                           { return som.getNeuron(index); });
+    }
+
+    Codebook Codebook::sigmaFromSom(const Som &som)
+    {
+        return copyFromSom(som, [&som](SomIndex index)
+                           { return som.getSigmaNeuron(index); });
+    }
+
+    void Codebook::applyTo(Som &som) const
+    {
+        for (size_t yIndex{0}; yIndex < m_height; ++yIndex)
+        {
+            for (size_t xIndex{0}; xIndex < m_width; ++xIndex)
+            {
+                const auto neuron = Eigen::Map<const Eigen::VectorXf>(getNeuron(getIndex(xIndex, yIndex)), m_depth);
+                som.setNeuron(SomIndex{xIndex, yIndex}, neuron);
+            }
+        }
+    }
+
+    bool Codebook::save(const std::string &path) const
+    {
+        auto file = std::ofstream(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        const uint64_t header[3] = {m_width, m_height, m_depth};
+        file.write(reinterpret_cast<const char *>(header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(m_values.data()), static_cast<std::streamsize>(m_values.size() * sizeof(float)));
+
+        return static_cast<bool>(file);
+    }
+
+    std::optional<Codebook> Codebook::load(const std::string &path)
+    {
+        auto file = std::ifstream(path, std::ios::binary);
+        if (!file)
+            return {};
+
+        uint64_t header[3] = {0, 0, 0};
+        if (!file.read(reinterpret_cast<char *>(header), sizeof(header)))
+            return {};
+
+        /* The dimensions have to account for exactly the rest of the file before anything is allocated */
+        const auto headerEnd = file.tellg();
+        file.seekg(0, std::ios::end);
+        const auto payload = static_cast<uint64_t>(file.tellg() - headerEnd);
+        file.seekg(headerEnd);
+        const auto cells = header[0] * header[1];
+        if (header[0] == 0 || header[1] == 0 || header[2] == 0 || cells / header[0] != header[1] ||
+            payload % sizeof(float) != 0 || payload / sizeof(float) / cells != header[2] || payload / sizeof(float) % cells != 0)
+        {
+            std::cerr << path << ": not a codebook checkpoint\n";
+            return {};
+        }
+
+        auto codebook = Codebook(header[0], header[1], header[2]);
+        if (!file.read(reinterpret_cast<char *>(codebook.m_values.data()), static_cast<std::streamsize>(codebook.m_values.size() * sizeof(float))))
+            return {};
+
+        return codebook;
+    }
+}
@@ -0,0 +1,182 @@
+#include "colormap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define VSOM_COLORMAP_SSE2
+#endif
+
+namespace VSOMExplorer
+{
+    namespace
+    {
+        /* Control points, interpolated linearly into the lookup table */
+        constexpr uint32_t grayscaleStops[] = {0x000000, 0xffffff};
+        constexpr uint32_t viridisStops[] = {0x440154, 0x472d7b, 0x3b528b, 0x2c728e, 0x21918c, 0x28ae80, 0x5ec962, 0xaddc30, 0xfde725};
+        constexpr uint32_t magmaStops[] = {0x000004, 0x1c1044, 0x4f127b, 0x812581, 0xb5367a, 0xe55064, 0xfb8761, 0xfec287, 0xfcfdbf};
+        constexpr uint32_t divergingStops[] = {0x3b4cc0, 0x8db0fe, 0xdddddd, 0xf49a7b, 0xb40426};
+
+        template <size_t N>
+        std::vector<uint32_t> interpolate(const uint32_t (&stops)[N], size_t entries)
+        {
+            auto lut = std::vector<uint32_t>(entries);
+            for (size_t entry{0}; entry < entries; ++entry)
+            {
+                const auto position = entries > 1 ? static_cast<double>(entry) * (N - 1) / static_cast<double>(entries - 1) : 0.0;
+                const auto stop = std::min(static_cast<size_t>(position), N - 2);
+                const auto t = position - static_cast<double>(stop);
+
+                uint8_t channels[3];
+                for (size_t channel{0}; channel < 3; ++channel)
+                {
+                    const auto shift = 16 - 8 * channel;
+                    const auto from = static_cast<double>((stops[stop] >> shift) & 0xff);
+                    const auto to = static_cast<double>((stops[stop + 1] >> shift) & 0xff);
+                    channels[channel] = static_cast<uint8_t>(std::lround(from + (to - from) * t));
+                }
+                lut[entry] = packColor(channels[0], channels[1], channels[2]);
+            }
+            return lut;
+        }
+
+        /* log2(1 + max(value, 0)) from the exponent bits and a polynomial in the mantissa, within 3e-5.
+           The SSE2 version below does the same operations so both paths agree exactly */
+        float logScale(float value)
+        {
+            const auto x = 1.f + (value > 0.f ? value : 0.f);
+            uint32_t bits;
+            std::memcpy(&bits, &x, sizeof(bits));
+
+            const auto exponent = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+            const auto mantissaBits = (bits & 0x007fffffu) | 0x3f800000u;
+            float mantissa;
+            std::memcpy(&mantissa, &mantissaBits, sizeof(mantissa));
+
+            const auto u = mantissa - 1.f;
+            return exponent + u * (1.4418255f + u * (-0.7086789f + u * (0.4154112f + u * (-0.1944083f + u * 0.045879f))));
+        }
+
+#ifdef VSOM_COLORMAP_SSE2
+        __m128 logScale(__m128 value)
+        {
+            const auto x = _mm_add_ps(_mm_set1_ps(1.f), _mm_max_ps(value, _mm_setzero_ps()));
+            const auto bits = _mm_castps_si128(x);
+
+            const auto exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+            const auto mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+
+            const auto u = _mm_sub_ps(mantissa, _mm_set1_ps(1.f));
+            auto polynomial = _mm_set1_ps(0.045879f);
+            polynomial = _mm_add_ps(_mm_set1_ps(-0.1944083f), _mm_mul_ps(u, polynomial));
+            polynomial = _mm_add_ps(_mm_set1_ps(0.4154112f), _mm_mul_ps(u, polynomial));
+            polynomial = _mm_add_ps(_mm_set1_ps(-0.7086789f), _mm_mul_ps(u, polynomial));
+            polynomial = _mm_add_ps(_mm_set1_ps(1.4418255f), _mm_mul_ps(u, polynomial));
+            return _mm_add_ps(exponent, _mm_mul_ps(u, polynomial));
+        }
+#endif
+    }
+
+    Colormap::Colormap(ColormapName name, size_t entries)
+        : m_name{static_cast<size_t>(name) < colormapCount ? name : ColormapName::Grayscale}
+    {
+        entries = std::max<size_t>(entries, 2);
+
+        switch (m_name)
+        {
+        case ColormapName::Viridis:
+            m_lut = interpolate(viridisStops, entries);
+            break;
+        case ColormapName::Magma:
+            m_lut = interpolate(magmaStops, entries);
+            break;
+        case ColormapName::Diverging:
+            m_lut = interpolate(divergingStops, entries);
+            break;
+        case ColormapName::Grayscale:
+        default:
+            m_lut = interpolate(grayscaleStops, entries);
+            break;
+        }
+    }
+
+    void Colormap::apply(const float *values, size_t count, float min, float max, const ColorRange &range, bool logScaled, uint32_t *colors) const
+    {
+        if (logScaled)
+        {
+            min = logScale(min);
+            max = logScale(max);
+        }
+
+        /* ((value - min) / (max - min) * 255 - lower) / (upper - lower) folded into one multiply-add */
+        const auto span = max > min ? max - min : 1.f;
+        const auto zoom = range.upper > range.lower ? range.upper - range.lower : 1.f;
+        const auto scale = 255.f / (span * zoom);
+        const auto offset = -(min * 255.f / span + range.lower) / zoom;
+        const auto last = static_cast<float>(m_lut.size() - 1);
+        const auto *lut = m_lut.data();
+
+        size_t i{0};
+#ifdef VSOM_COLORMAP_SSE2
+        const auto scales = _mm_set1_ps(scale);
+        const auto offsets = _mm_set1_ps(offset);
+        const auto lasts = _mm_set1_ps(last);
+        const auto halves = _mm_set1_ps(0.5f);
+        const auto zeros = _mm_setzero_ps();
+        const auto ones = _mm_set1_ps(1.f);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            auto x = _mm_loadu_ps(values + i);
+            if (logScaled)
+                x = logScale(x);
+
+            /* max first so NaN ends up as the lowest color */
+            const auto t = _mm_min_ps(_mm_max_ps(_mm_add_ps(_mm_mul_ps(x, scales), offsets), zeros), ones);
+            alignas(16) int32_t indices[4];
+            _mm_store_si128(reinterpret_cast<__m128i *>(indices), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(t, lasts), halves)));
+
+            colors[i] = lut[indices[0]];
+            colors[i + 1] = lut[indices[1]];
+            colors[i + 2] = lut[indices[2]];
+            colors[i + 3] = lut[indices[3]];
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            const auto x = logScaled ? logScale(values[i]) : values[i];
+            const auto scaled = x * scale + offset;
+            const auto t = std::min(scaled > 0.f ? scaled : 0.f, 1.f);
+            colors[i] = lut[static_cast<int32_t>(t * last + 0.5f)];
+        }
+    }
+
+    void scaleToBytes(const float *values, size_t count, float min, float max, uint8_t *bytes)
+    {
+        const auto scale = 255.f / (max - min);
+
+        size_t i{0};
+#ifdef VSOM_COLORMAP_SSE2
+        const auto mins = _mm_set1_ps(min);
+        const auto scales = _mm_set1_ps(scale);
+        const auto zeros = _mm_setzero_ps();
+        const auto tops = _mm_set1_ps(255.f);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const auto scaled = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(values + i), mins), scales);
+            const auto clamped = _mm_min_ps(_mm_max_ps(scaled, zeros), tops);
+            const auto words = _mm_packs_epi32(_mm_cvttps_epi32(clamped), _mm_setzero_si128());
+            const auto packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, _mm_setzero_si128()));
+            std::memcpy(bytes + i, &packed, 4);
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            const auto scaled = (values[i] - min) * scale;
+            bytes[i] = static_cast<uint8_t>(std::min(scaled > 0.f ? scaled : 0.f, 255.f));
+        }
+    }
+}
@@ -0,0 +1,493 @@
+#include "dataLoaders.h"
+#include "mappedFile.h"
+#include "threadPool.h"
+
+#include <libsom/SqliteDataLoader.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <thread>
+
+namespace VSOMExplorer
+{
+    namespace
+    {
+        constexpr size_t sniffBytes = 4096;
+        constexpr size_t minimumChunkBytes = size_t{1} << 20;
+        constexpr size_t chunksPerThread = 4;
+        /* Largest mantissa and powers of ten a float holds exactly */
+        constexpr uint64_t maxExactMantissa = uint64_t{1} << 24;
+        constexpr float powersOfTen[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+        constexpr int maxExactExponent = 10;
+
+        bool isDigit(char c) { return c >= '0' && c <= '9'; }
+        bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '"'; }
+
+        /* Everything the fast path can not represent exactly: long mantissas, large exponents, nan and inf */
+        bool parseFloatSlow(const char *begin, const char *end, float *value)
+        {
+            char buffer[128];
+            const auto length = static_cast<size_t>(end - begin);
+            if (length >= sizeof(buffer))
+                return false;
+
+            std::memcpy(buffer, begin, length);
+            buffer[length] = '\0';
+
+            char *parsed = nullptr;
+            const auto result = std::strtof(buffer, &parsed);
+            if (parsed != buffer + length)
+                return false;
+
+            *value = result;
+            return true;
+        }
+
+        const char *lineEnd(const char *begin, const char *end)
+        {
+            const auto *newline = static_cast<const char *>(std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+            return newline != nullptr ? newline : end;
+        }
+
+        const char *nextLine(const char *begin, const char *end)
+        {
+            const auto *newline = lineEnd(begin, end);
+            return newline != end ? newline + 1 : end;
+        }
+
+        bool isEmptyLine(const char *begin, const char *end)
+        {
+            return std::all_of(begin, end, [](char c)
+                               { return c == ' ' || c == '\t' || c == '\r'; });
+        }
+
+        const char *fieldEnd(const char *begin, const char *end, char delimiter)
+        {
+            const auto *found = static_cast<const char *>(std::memchr(begin, delimiter, static_cast<size_t>(end - begin)));
+            return found != nullptr ? found : end;
+        }
+
+        std::vector<std::string> splitNames(const char *begin, const char *end, char delimiter)
+        {
+            auto names = std::vector<std::string>{};
+            for (auto *field = begin;;)
+            {
+                const auto *fieldLast = fieldEnd(field, end, delimiter);
+                auto *first = field;
+                auto *last = fieldLast;
+                while (first < last && isBlank(*first))
+                    ++first;
+                while (last > first && isBlank(last[-1]))
+                    --last;
+                names.emplace_back(first, last);
+
+                if (fieldLast == end)
+                    break;
+                field = fieldLast + 1;
+            }
+            return names;
+        }
+
+        /* Fills one row, false if a field is missing or does not parse */
+        bool parseRow(const char *begin, const char *end, char delimiter, float *row, size_t columns)
+        {
+            const auto *field = begin;
+            for (size_t column{0}; column < columns; ++column)
+            {
+                if (field == nullptr)
+                    return false;
+
+                const auto *fieldLast = fieldEnd(field, end, delimiter);
+                if (!parseFloat(field, fieldLast, row + column))
+                    return false;
+                field = fieldLast != end ? fieldLast + 1 : nullptr;
+            }
+            return true;
+        }
+
+        uint32_t readBigEndian32(const unsigned char *bytes)
+        {
+            return (uint32_t{bytes[0]} << 24) | (uint32_t{bytes[1]} << 16) | (uint32_t{bytes[2]} << 8) | uint32_t{bytes[3]};
+        }
+
+        size_t idxElementSize(unsigned char type)
+        {
+            switch (type)
+            {
+            case 0x08:
+            case 0x09:
+                return 1;
+            case 0x0B:
+                return 2;
+            case 0x0C:
+            case 0x0D:
+                return 4;
+            case 0x0E:
+                return 8;
+            default:
+                return 0;
+            }
+        }
+
+        template <typename Decode>
+        void convertIdx(const unsigned char *source, float *destination, size_t count, size_t elementSize, Decode decode)
+        {
+            for (size_t i{0}; i < count; ++i)
+                destination[i] = decode(source + i * elementSize);
+        }
+
+        std::vector<std::string> columnNames(size_t columns)
+        {
+            auto names = std::vector<std::string>(columns);
+            for (size_t column{0}; column < columns; ++column)
+                names[column] = "Column " + std::to_string(column);
+            return names;
+        }
+    }
+
+    const char *dataFormatName(DataFormat format)
+    {
+        switch (format)
+        {
+        case DataFormat::Sqlite:
+            return "SQLite";
+        case DataFormat::Csv:
+            return "CSV";
+        case DataFormat::Tsv:
+            return "TSV";
+        case DataFormat::Idx:
+            return "IDX";
+        default:
+            return "Unknown";
+        }
+    }
+
+    DataFormat detectDataFormat(const std::string &path)
+    {
+        auto *file = std::fopen(path.c_str(), "rb");
+        if (file == nullptr)
+            return DataFormat::Unknown;
+
+        char buffer[sniffBytes];
+        const auto length = std::fread(buffer, 1, sizeof(buffer), file);
+        std::fclose(file);
+
+        const auto *bytes = reinterpret_cast<const unsigned char *>(buffer);
+        if (length >= 16 && std::memcmp(buffer, "SQLite format 3", 16) == 0)
+            return DataFormat::Sqlite;
+        if (length >= 4 && bytes[0] == 0 && bytes[1] == 0 && idxElementSize(bytes[2]) != 0 && bytes[3] >= 1 && bytes[3] <= 4)
+            return DataFormat::Idx;
+        if (length == 0 || std::memchr(buffer, '\0', length) != nullptr)
+            return DataFormat::Unknown;
+
+        const auto *line = buffer;
+        const auto *end = buffer + length;
+        while (line != end && isEmptyLine(line, lineEnd(line, end)))
+            line = nextLine(line, end);
+
+        const auto *last = lineEnd(line, end);
+        const auto tabs = std::count(line, last, '\t');
+        const auto commas = std::count(line, last, ',');
+        return tabs > commas ? DataFormat::Tsv : DataFormat::Csv;
+    }
+
+    bool parseFloat(const char *begin, const char *end, float *value)
+    {
+        while (begin < end && isBlank(*begin))
+            ++begin;
+        while (end > begin && isBlank(end[-1]))
+            --end;
+        if (begin == end)
+            return false;
+
+        const auto *position = begin;
+        const bool negative = *position == '-';
+        if (*position == '-' || *position == '+')
+            ++position;
+
+        uint64_t mantissa{0};
+        int exponent{0};
+        bool anyDigit = false;
+        for (; position < end && isDigit(*position); ++position)
+        {
+            if (mantissa >= maxExactMantissa / 10)
+                return parseFloatSlow(begin, end, value);
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*position - '0');
+            anyDigit = true;
+        }
+        if (position < end && *position == '.')
+        {
+            for (++position; position < end && isDigit(*position); ++position)
+            {
+                if (mantissa >= maxExactMantissa / 10)
+                    return parseFloatSlow(begin, end, value);
+                mantissa = mantissa * 10 + static_cast<uint64_t>(*position - '0');
+                --exponent;
+                anyDigit = true;
+            }
+        }
+        if (!anyDigit)
+            return parseFloatSlow(begin, end, value);
+
+        if (position < end && (*position == 'e' || *position == 'E'))
+        {
+            ++position;
+            const bool negativeExponent = position < end && *position == '-';
+            if (position < end && (*position == '-' || *position == '+'))
+                ++position;
+
+            int written{0};
+            bool anyExponentDigit = false;
+            for (; position < end && isDigit(*position); ++position)
+            {
+                if (written < 10000)
+                    written = written * 10 + (*position - '0');
+                anyExponentDigit = true;
+            }
+            if (!anyExponentDigit)
+                return false;
+            exponent += negativeExponent ? -written : written;
+        }
+        if (position != end)
+            return false;
+
+        /* Mantissa and power of ten are exact floats here, so the one float operation rounds once,
+           as strtof does. Going through double would round twice and can be off by one ulp. */
+        if (exponent < -maxExactExponent || exponent > maxExactExponent)
+            return parseFloatSlow(begin, end, value);
+
+        auto result = static_cast<float>(mantissa);
+        result = exponent < 0 ? result / powersOfTen[-exponent] : result * powersOfTen[exponent];
+        *value = negative ? -result : result;
+        return true;
+    }
+
+    std::optional<DataMatrix> readDelimited(const std::string &path, char delimiter, size_t threads)
+    {
+        const auto file = MappedFile(path);
+        if (!file.isOpen())
+            return {};
+
+        const auto *begin = file.data();
+        const auto *end = begin + file.size();
+        if (file.size() >= 3 && std::memcmp(begin, "\xEF\xBB\xBF", 3) == 0)
+            begin += 3;
+        while (begin != end && isEmptyLine(begin, lineEnd(begin, end)))
+            begin = nextLine(begin, end);
+        if (begin == end)
+            return {};
+
+        /* The first line decides the column count, and whether it holds names or data */
+        const auto *firstLineEnd = lineEnd(begin, end);
+        auto names = splitNames(begin, firstLineEnd, delimiter);
+        const auto columns = names.size();
+        const bool hasHeader = std::none_of(names.begin(), names.end(), [](const std::string &name)
+                                            { float value;
+                                              return parseFloat(name.data(), name.data() + name.size(), &value); });
+        const auto *body = hasHeader ? nextLine(begin, end) : begin;
+        if (!hasHeader)
+            names = columnNames(columns);
+
+        auto pool = ThreadPool(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency()));
+        const auto bodyBytes = static_cast<size_t>(end - body);
+        const auto chunkCount = std::max<size_t>(1, std::min(bodyBytes / minimumChunkBytes, pool.size() * chunksPerThread));
+
+        /* Chunk boundaries are moved forward to the next line start, so every line belongs to exactly one chunk */
+        auto bounds = std::vector<const char *>(chunkCount + 1, end);
+        bounds[0] = body;
+        for (size_t chunk{1}; chunk < chunkCount; ++chunk)
+        {
+            const auto *split = body + bodyBytes * chunk / chunkCount;
+            if (split[-1] != '\n')
+                split = nextLine(split, end);
+            bounds[chunk] = std::max(bounds[chunk - 1], split);
+        }
+
+        /* First pass counts rows so the second can write each chunk straight into its final place */
+        auto rowOffsets = std::vector<size_t>(chunkCount + 1, 0);
+        pool.parallelFor(chunkCount, [&](size_t chunk)
+                         {
+            size_t rows{0};
+            for (auto *line = bounds[chunk]; line < bounds[chunk + 1]; line = nextLine(line, end))
+                rows += isEmptyLine(line, lineEnd(line, end)) ? 0 : 1;
+            rowOffsets[chunk + 1] = rows; });
+        for (size_t chunk{0}; chunk < chunkCount; ++chunk)
+            rowOffsets[chunk + 1] += rowOffsets[chunk];
+        if (rowOffsets[chunkCount] == 0)
+            return {};
+
+        auto matrix = DataMatrix(rowOffsets[chunkCount], columns);
+        auto malformed = std::vector<size_t>(chunkCount, 0);
+        auto firstMalformed = std::vector<size_t>(chunkCount, rowOffsets[chunkCount]);
+        pool.parallelFor(chunkCount, [&](size_t chunk)
+                         {
+            auto row = rowOffsets[chunk];
+            for (auto *line = bounds[chunk]; line < bounds[chunk + 1]; line = nextLine(line, end))
+            {
+                const auto *last = lineEnd(line, end);
+                if (isEmptyLine(line, last))
+                    continue;
+                if (!parseRow(line, last, delimiter, matrix.getRow(row), columns))
+                {
+                    firstMalformed[chunk] = std::min(firstMalformed[chunk], row);
+                    ++malformed[chunk];
+                }
+                ++row;
+            } });
+
+        /* A hole in the data is not something to train on, the file is rejected */
+        const auto malformedRows = std::accumulate(malformed.begin(), malformed.end(), size_t{0});
+        if (malformedRows != 0)
+        {
+            const auto first = *std::min_element(firstMalformed.begin(), firstMalformed.end());
+            std::fprintf(stderr, "%s: %zu rows with missing or unreadable fields, the first is data row %zu\n", path.c_str(), malformedRows, first + 1);
+            return {};
+        }
+
+        matrix.setNames(std::move(names));
+        return matrix;
+    }
+
+    std::optional<DataMatrix> readIdx(const std::string &path)
+    {
+        const auto file = MappedFile(path);
+        if (!file.isOpen() || file.size() < 4)
+            return {};
+
+        const auto *bytes = reinterpret_cast<const unsigned char *>(file.data());
+        const auto elementSize = idxElementSize(bytes[2]);
+        const size_t dimensions = bytes[3];
+        const auto headerBytes = 4 + 4 * dimensions;
+        if (bytes[0] != 0 || bytes[1] != 0 || elementSize == 0 || dimensions == 0 || file.size() < headerBytes)
+            return {};
+
+        const size_t rows = readBigEndian32(bytes + 4);
+        size_t columns{1};
+        for (size_t dimension{1}; dimension < dimensions; ++dimension)
+            columns *= readBigEndian32(bytes + 4 + 4 * dimension);
+        if (rows == 0 || columns == 0 || (file.size() - headerBytes) / elementSize / columns < rows)
+            return {};
+
+        auto matrix = DataMatrix(rows, columns);
+        const auto *source = bytes + headerBytes;
+        auto *destination = matrix.getRow(0);
+        const auto count = rows * columns;
+
+        /* IDX stores everything big endian */
+        switch (bytes[2])
+        {
+        case 0x08:
+            convertIdx(source, destination, count, elementSize, [](const unsigned char *element)
+                       { return static_cast<float>(element[0]); });
+            break;
+        case 0x09:
+            convertIdx(source, destination, count, elementSize, [](const unsigned char *element)
+                       { return static_cast<float>(static_cast<int8_t>(element[0])); });
+            break;
+        case 0x0B:
+            convertIdx(source, destination, count, elementSize, [](const unsigned char *element)
+                       { return static_cast<float>(static_cast<int16_t>((element[0] << 8) | element[1])); });
+            break;
+        case 0x0C:
+            convertIdx(source, destination, count, elementSize, [](const unsigned char *element)
+                       { return static_cast<float>(static_cast<int32_t>(readBigEndian32(element))); });
+            break;
+        case 0x0D:
+            convertIdx(source, destination, count, elementSize, [](const unsigned char *element)
+                       { const auto bits = readBigEndian32(element);
+                         float value;
+                         std::memcpy(&value, &bits, sizeof(value));
+                         return value; });
+            break;
+        case 0x0E:
+            convertIdx(source, destination, count, elementSize, [](const unsigned char *element)
+                       { const auto bits = (uint64_t{readBigEndian32(element)} << 32) | readBigEndian32(element + 4);
+                         double value;
+                         std::memcpy(&value, &bits, sizeof(value));
+                         return static_cast<float>(value); });
+            break;
+        }
+
+        matrix.setNames(columnNames(columns));
+        return matrix;
+    }
+
+    int MatrixDataLoader::open(const char *path)
+    {
+        auto matrix = std::optional<DataMatrix>{};
+        switch (m_format)
+        {
+        case DataFormat::Csv:
+            matrix = readDelimited(path, ',');
+            break;
+        case DataFormat::Tsv:
+            matrix = readDelimited(path, '\t');
+            break;
+        case DataFormat::Idx:
+            matrix = readIdx(path);
+            break;
+        default:
+            break;
+        }
+
+        if (!matrix)
+            return 0;
+
+        m_matrix = std::make_shared<DataMatrix>(std::move(*matrix));
+        return 1;
+    }
+
+    size_t MatrixDataLoader::getDepth() const
+    {
+        return m_matrix != nullptr ? m_matrix->vectorLength() : 0;
+    }
+
+    std::vector<std::string> MatrixDataLoader::getNames() const
+    {
+        return m_matrix != nullptr ? m_matrix->getNames() : std::vector<std::string>{};
+    }
+
+    size_t MatrixDataLoader::getNumberOfRows() const
+    {
+        return m_matrix != nullptr ? m_matrix->size() : 0;
+    }
+
+    Eigen::VectorXf MatrixDataLoader::getRow(size_t index) const
+    {
+        return Eigen::Map<const Eigen::VectorXf>(m_matrix->getRow(index), static_cast<Eigen::Index>(m_matrix->vectorLength()));
+    }
+
+    std::unique_ptr<IDataLoader> openDataLoader(const std::string &path, const std::string &columnSpec)
+    {
+        auto loader = std::unique_ptr<IDataLoader>();
+        const auto format = detectDataFormat(path);
+        switch (format)
+        {
+        case DataFormat::Sqlite:
+            loader = std::make_unique<SqliteDataLoader>(columnSpec.c_str());
+            break;
+        case DataFormat::Csv:
+        case DataFormat::Tsv:
+        case DataFormat::Idx:
+            loader = std::make_unique<MatrixDataLoader>(format);
+            break;
+        default:
+            return nullptr;
+        }
+
+        if (loader->open(path.c_str()) == 0)
+            return nullptr;
+        return loader;
+    }
+
+    std::shared_ptr<DataMatrix> denseMatrix(const IDataLoader *loader, DataSet &dataset)
+    {
+        if (const auto *matrixLoader = dynamic_cast<const MatrixDataLoader *>(loader); matrixLoader != nullptr && matrixLoader->getMatrix() != nullptr)
+            return matrixLoader->getMatrix();
+        return std::make_shared<DataMatrix>(DataMatrix::fromDataSet(dataset));
+    }
+}
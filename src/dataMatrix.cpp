@@ -0,0 +1,25 @@
+#include "dataMatrix.h"
+
+namespace VSOMExplorer
+{
+    DataMatrix::DataMatrix(size_t rows, size_t columns)
+        : m_rows{rows}, m_columns{columns}, m_values(rows * columns, 0.f)
+    {
+    }
+
+    DataMatrix DataMatrix::fromDataSet(DataSet &dataset)
+    {
+        const auto rows = dataset.getPreviewData(dataset.size());
+        auto matrix = DataMatrix(rows.size(), dataset.vectorLength());
+
+        for (size_t row{0}; row < matrix.size(); ++row)
+        {
+            auto *destination = matrix.getRow(row);
+            for (size_t column{0}; column < matrix.vectorLength(); ++column)
+                destination[column] = rows[row][column];
+        }
+        matrix.setNames(dataset.getNames());
+
+        return matrix;
+    }
+}
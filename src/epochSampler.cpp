@@ -0,0 +1,125 @@
+#include "epochSampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <numeric>
+
+namespace VSOMExplorer
+{
+    EpochSampler::EpochSampler(const DataMatrix &data, EpochSampling sampling, double fraction, size_t sampleSize,
+                               long labelColumn, unsigned seed)
+        : m_data{data}, m_sampling{sampling}, m_fraction{std::clamp(fraction, 0.0, 1.0)},
+          m_sampleSize{std::min(sampleSize, data.size())}, m_random{seed}
+    {
+        m_allRows.resize(m_data.size());
+        std::iota(m_allRows.begin(), m_allRows.end(), size_t{0});
+
+        if (labelColumn >= 0 && static_cast<size_t>(labelColumn) < m_data.vectorLength())
+        {
+            /* NaN compares false both ways and would break the map's ordering */
+            auto byLabel = std::map<float, std::vector<size_t>>{};
+            for (size_t row{0}; row < m_data.size() && !m_tooManyClasses; ++row)
+            {
+                const auto label = m_data.getRow(row)[labelColumn];
+                if (std::isnan(label))
+                    continue;
+
+                byLabel[label].push_back(row);
+                ++m_stratifiedRows;
+                m_tooManyClasses = byLabel.size() > maxClasses;
+            }
+
+            if (m_tooManyClasses)
+                std::cerr << "Column " << labelColumn << " has more than " << maxClasses << " distinct values, sampling without classes\n";
+            else
+            {
+                for (auto &[label, rows] : byLabel)
+                    m_strata.push_back(std::move(rows));
+            }
+        }
+
+        if (m_strata.empty())
+        {
+            m_strata.push_back(m_allRows);
+            m_stratifiedRows = m_allRows.size();
+        }
+    }
+
+    void EpochSampler::reservoir(const std::vector<size_t> &candidates, size_t count)
+    {
+        const auto first = m_rows.size();
+        count = std::min(count, candidates.size());
+        m_rows.insert(m_rows.end(), candidates.begin(), candidates.begin() + count);
+
+        for (size_t i{count}; i < candidates.size(); ++i)
+        {
+            const auto slot = std::uniform_int_distribution<size_t>(0, i)(m_random);
+            if (slot < count)
+                m_rows[first + slot] = candidates[i];
+        }
+    }
+
+    void EpochSampler::bernoulli(const std::vector<size_t> &candidates)
+    {
+        auto keep = std::bernoulli_distribution(m_fraction);
+        for (const auto row : candidates)
+        {
+            if (keep(m_random))
+                m_rows.push_back(row);
+        }
+    }
+
+    std::vector<size_t> EpochSampler::stratumQuotas(size_t total) const
+    {
+        /* Proportional shares, the rows lost to rounding go to the largest remainders */
+        auto quotas = std::vector<size_t>(m_strata.size());
+        if (m_stratifiedRows == 0)
+            return quotas;
+
+        auto remainders = std::vector<std::pair<double, size_t>>{};
+        size_t assigned{0};
+
+        for (size_t stratum{0}; stratum < m_strata.size(); ++stratum)
+        {
+            const auto exact = static_cast<double>(total) * static_cast<double>(m_strata[stratum].size()) / static_cast<double>(m_stratifiedRows);
+            quotas[stratum] = static_cast<size_t>(std::floor(exact));
+            assigned += quotas[stratum];
+            remainders.emplace_back(exact - std::floor(exact), stratum);
+        }
+
+        std::stable_sort(remainders.begin(), remainders.end(), [](const auto &a, const auto &b)
+                         { return a.first > b.first; });
+        for (size_t i{0}; assigned < total && i < remainders.size(); ++i, ++assigned)
+            ++quotas[remainders[i].second];
+
+        return quotas;
+    }
+
+    const std::vector<size_t> &EpochSampler::next(bool full)
+    {
+        if (full || m_sampling == EpochSampling::Full)
+            return m_allRows;
+
+        m_rows.clear();
+
+        if (m_strata.size() == 1 && m_sampling == EpochSampling::Fraction)
+        {
+            bernoulli(m_strata.front());
+        }
+        else
+        {
+            const auto total = m_sampling == EpochSampling::Fraction
+                                   ? static_cast<size_t>(std::llround(m_fraction * static_cast<double>(m_stratifiedRows)))
+                                   : std::min(m_sampleSize, m_stratifiedRows);
+            const auto quotas = stratumQuotas(total);
+
+            for (size_t stratum{0}; stratum < m_strata.size(); ++stratum)
+                reservoir(m_strata[stratum], quotas[stratum]);
+        }
+
+        std::sort(m_rows.begin(), m_rows.end());
+        return m_rows;
+    }
+}
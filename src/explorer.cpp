@@ -1,30 +1,24 @@
 #include "explorer.h"
+#include "allocationCounter.h"
+#include "mapRaster.h"
 
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <thread>
 #include <functional>
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 
 namespace VSOMExplorer
 {
-    int Handler::scaleColorToUCharRange(float value, float max, float min)
+    namespace
     {
-        auto staticallyScaledValue = (value - min) * 255 / (max - min);
-
-        return static_cast<int>(staticallyScaledValue > 255.f ? 255.f : staticallyScaledValue < 0.f ? 0.f
-                                                                                                    : staticallyScaledValue);
-    };
-
-    int Handler::scaleColorToUCharRangeWithZoom(float value, float max, float min, int outMax, int outMin)
-    {
-        auto scaledValue = scaleColorToUCharRange(value, max, min);
-
-        auto span = outMax - outMin;
-        auto dynamicallyScaledValue = (scaledValue - outMin) * 255.0 / span;
-        auto contrainedValue = dynamicallyScaledValue < 0. ? 0. : dynamicallyScaledValue > 255.0 ? 255.0
-                                                                                                 : dynamicallyScaledValue;
-        return static_cast<int>(contrainedValue);
+        /* ImGuiFileDialog takes its keys as std::string, built once rather than on every frame */
+        const auto chooseFileDialogKey = std::string{"ChooseFileDlgKey"};
+        const auto openWorkspaceDialogKey = std::string{"OpenWorkspaceDlgKey"};
+        const auto saveWorkspaceDialogKey = std::string{"SaveWorkspaceDlgKey"};
     }
 
     void Handler::RenderCombo(const char *name, const char *const *labels, const size_t numberOfChoices, size_t *currentId, const char *combo_preview_value)
@@ -44,21 +38,39 @@ namespace VSOMExplorer
         }
     }
 
-    void Handler::RenderCombo(const std::string &name, const std::vector<std::string> &labels, size_t *currentId, const std::string &combo_preview_value)
+    void Handler::RenderCombo(const char *name, const std::vector<const char *> &labels, size_t *currentId)
     {
-        // Convert vector<string> to const char* const*
-        const std::vector<const char *> c_labels = [&labels]()
-        {
-            auto c_l = std::vector<const char *>{};
-            c_l.reserve(labels.size());
+        const char *preview = *currentId < labels.size() ? labels[*currentId] : "";
+        RenderCombo(name, labels.data(), labels.size(), currentId, preview);
+    }
 
-            for (auto &s : labels)
-                c_l.push_back(&s[0]);
+    std::vector<float> Handler::getDatasetWeights()
+    {
+        auto weights = std::vector<float>(m_dataset->vectorLength());
+        for (size_t column{0}; column < weights.size(); ++column)
+            weights[column] = m_dataset->getWeight(column);
+
+        return weights;
+    }
 
-            return c_l;
-        }();
+    size_t Handler::getSomDepth() const
+    {
+        return m_som.getWidth() * m_som.getHeight() > 0 ? static_cast<size_t>(m_som.getNeuron(size_t{0}).size()) : 0;
+    }
 
-        RenderCombo(name.c_str(), c_labels.data(), labels.size(), currentId, combo_preview_value.c_str());
+    bool Handler::ownsTrainingMatrix() const
+    {
+        const auto *matrixLoader = dynamic_cast<const MatrixDataLoader *>(m_dataLoader.get());
+        return m_dataMatrix != nullptr && (matrixLoader == nullptr || matrixLoader->getMatrix() != m_dataMatrix);
+    }
+
+    bool Handler::BeginWindow(const char *name, size_t *visibleCounter)
+    {
+        const auto visible = ImGui::Begin(name);
+        if (visible)
+            ++*visibleCounter;
+
+        return visible;
     }
 
     void Handler::LoadMainMenu()
@@ -70,10 +82,20 @@ namespace VSOMExplorer
                 if (ImGui::MenuItem("New", "CTRL+N"))
                 {
                 }
-                if (ImGui::MenuItem("Open data", "CTRL+O"))
+                /* The training thread works on the current dataset and model, neither may be swapped under it */
+                if (ImGui::MenuItem("Open data", "CTRL+O", false, !isWorkspaceLoading() && !isTraining()))
                 {
                     // open Dialog Simple
-                    ImGuiFileDialog::Instance()->OpenDialog("ChooseFileDlgKey", "Choose File", "*,*.*", ".", 1, nullptr, ImGuiFileDialogFlags_Modal);
+                    ImGuiFileDialog::Instance()->OpenDialog(chooseFileDialogKey, "Choose File", "*,*.*", ".", 1, nullptr, ImGuiFileDialogFlags_Modal);
+                }
+                if (ImGui::MenuItem("Open workspace", nullptr, false, !isWorkspaceLoading() && !isTraining()))
+                {
+                    ImGuiFileDialog::Instance()->OpenDialog(openWorkspaceDialogKey, "Open Workspace", ".vsom,*.*", ".", 1, nullptr, ImGuiFileDialogFlags_Modal);
+                }
+                /* The model is saved from the Som, which the training thread is writing */
+                if (ImGui::MenuItem("Save workspace", nullptr, false, !isTraining()))
+                {
+                    ImGuiFileDialog::Instance()->OpenDialog(saveWorkspaceDialogKey, "Save Workspace", ".vsom", ".", 1, nullptr, ImGuiFileDialogFlags_Modal | ImGuiFileDialogFlags_ConfirmOverwrite);
                 }
                 if (ImGui::MenuItem("Quit", "CTRL+Q"))
                 {
@@ -100,11 +122,13 @@ namespace VSOMExplorer
                 }
                 ImGui::EndMenu();
             }
+            if (isWorkspaceLoading())
+                ImGui::TextDisabled("Loading workspace...");
             ImGui::EndMainMenuBar();
         }
 
         // display
-        if (ImGuiFileDialog::Instance()->Display("ChooseFileDlgKey"))
+        if (ImGuiFileDialog::Instance()->Display(chooseFileDialogKey))
         {
             // action if OK
             if (ImGuiFileDialog::Instance()->IsOk())
@@ -114,27 +138,142 @@ namespace VSOMExplorer
 
                 std::optional<size_t> lastDatasetDepth = m_dataLoader ? m_dataLoader->getDepth() : std::optional<size_t>{};
 
-                m_dataLoader = std::make_unique<SqliteDataLoader>("../data/columnSpec.txt");
-
-                /* Open new dataset */
-                if (m_dataLoader->open(filePathName.c_str()) != 0) 
+                /* Open new dataset, the loader is picked from the file's contents */
+                auto loader = openDataLoader(filePathName, "../data/columnSpec.txt");
+                if (loader != nullptr)
                 {
-                    m_dataset = std::unique_ptr<DataSet>(new DataSet(*m_dataLoader));
+                    m_dataset = std::unique_ptr<DataSet>(new DataSet(*loader));
+                    m_dataLoader = std::move(loader);
+                    ++m_datasetGeneration;
+                    m_dataMatrix.reset();
+                    m_previewData.reset();
+                    trainingSetPath = filePathName;
                     m_som = Som(10, 10, m_dataset->vectorLength());
+                    ResetHistory();
+                    ++m_modelGeneration;
                 }
             }
 
             // close
             ImGuiFileDialog::Instance()->Close();
         }
+
+        if (ImGuiFileDialog::Instance()->Display(openWorkspaceDialogKey))
+        {
+            if (ImGuiFileDialog::Instance()->IsOk())
+                OpenWorkspace(ImGuiFileDialog::Instance()->GetFilePathName());
+
+            ImGuiFileDialog::Instance()->Close();
+        }
+
+        if (ImGuiFileDialog::Instance()->Display(saveWorkspaceDialogKey))
+        {
+            if (ImGuiFileDialog::Instance()->IsOk())
+                SaveWorkspace(ImGuiFileDialog::Instance()->GetFilePathName());
+
+            ImGuiFileDialog::Instance()->Close();
+        }
+    }
+
+    void Handler::DrawCells(const ImU32 *colors, size_t xSteps, size_t ySteps, const ImVec2 &p, float xStepSize, float yStepSize)
+    {
+        ImDrawList *draw_list = ImGui::GetWindowDrawList();
+
+        for (size_t yIndex{0}; yIndex < ySteps; ++yIndex)
+        {
+            for (size_t xIndex{0}; xIndex < xSteps; ++xIndex)
+            {
+                const auto color = colors[yIndex * xSteps + xIndex];
+                draw_list->AddRectFilledMultiColor(ImVec2(p.x + xIndex * xStepSize, p.y + yIndex * yStepSize),
+                                                   ImVec2(p.x + (xIndex + 1) * xStepSize, p.y + (yIndex + 1) * yStepSize), color, color, color, color);
+            }
+        }
+    }
+
+    void Handler::DrawMap(HexGeometry &hex, const ImU32 *colors, size_t xSteps, size_t ySteps, const ImVec2 &size, size_t *hoverX, size_t *hoverY)
+    {
+        const auto origin = ImGui::GetCursorScreenPos();
+        const auto mouse = ImGui::GetMousePos();
+        size_t x{xSteps}, y{ySteps};
+
+        if (m_hexagonalTopology)
+        {
+            m_memoryBudget.touch(m_hexCache);
+            hex.update(xSteps, ySteps, size);
+            hex.hitTest(ImVec2(mouse.x - origin.x, mouse.y - origin.y), &x, &y);
+            hex.setColors(colors);
+            hex.draw(ImGui::GetWindowDrawList(), origin);
+        }
+        else
+        {
+            const auto xStepSize = size.x / xSteps;
+            const auto yStepSize = size.y / ySteps;
+
+            /* Hover neuron index */
+            x = static_cast<size_t>((mouse.x - origin.x - ImGui::GetScrollX()) / xStepSize);
+            y = static_cast<size_t>((mouse.y - origin.y - ImGui::GetScrollY()) / yStepSize);
+
+            DrawCells(colors, xSteps, ySteps, origin, xStepSize, yStepSize);
+        }
+
+        if (hoverX != nullptr && hoverY != nullptr)
+        {
+            *hoverX = x;
+            *hoverY = y;
+        }
+    }
+
+    void Handler::DrawQueryHighlights(const HexGeometry &hex, size_t xSteps, size_t ySteps, const ImVec2 &origin, const ImVec2 &size)
+    {
+        /* Results for another map size would point at the wrong cells */
+        if (m_queryResult.mapWidth != xSteps)
+            return;
+
+        auto *drawList = ImGui::GetWindowDrawList();
+        const auto xStepSize = size.x / xSteps;
+        const auto yStepSize = size.y / ySteps;
+        for (size_t rank{0}; rank < m_queryResult.neurons.size(); ++rank)
+        {
+            const auto index = m_queryResult.neurons[rank].index;
+            if (index >= xSteps * ySteps)
+                continue;
+
+            const auto x = index % xSteps;
+            const auto y = index / xSteps;
+            const auto color = rank == 0 ? IM_COL32(255, 255, 255, 255) : IM_COL32(255, 200, 0, 255);
+            const auto thickness = rank == 0 ? 3.f : 1.5f;
+            if (m_hexagonalTopology)
+                hex.outline(drawList, origin, x, y, color, thickness);
+            else
+                drawList->AddRect(ImVec2(origin.x + x * xStepSize, origin.y + y * yStepSize),
+                                  ImVec2(origin.x + (x + 1) * xStepSize, origin.y + (y + 1) * yStepSize), color, 0.f, 0, thickness);
+        }
+    }
+
+    void Handler::RenderValueGrid(const ValueGrid &grid, ColorRange &range, HexGeometry &hex, bool logScale)
+    {
+        auto &[upper, lower] = range;
+        ImGui::DragFloat("Upper", &upper, 0.2f, 0.0f, 255.0f, "%.0f");
+        ImGui::DragFloat("Lower", &lower, 0.2f, 0.0f, 255.0f, "%.0f");
+
+        const auto xSteps = grid.width;
+        const auto ySteps = grid.height;
+        if (xSteps == 0 || ySteps == 0)
+            return;
+
+        auto *colors = m_frameArena.allocate<ImU32>(xSteps * ySteps);
+        m_colormap.apply(grid.values.data(), xSteps * ySteps, 0.f, grid.maxValue, range, logScale, colors);
+
+        const auto size = m_hexagonalTopology ? ImGui::GetContentRegionAvail() : ImVec2(ImGui::GetWindowWidth(), ImGui::GetWindowHeight());
+        DrawMap(hex, colors, xSteps, ySteps, size, nullptr, nullptr);
     }
 
     void Handler::DatasetEditor()
     {
-        if (ImGui::Begin("Dataset Editor") && m_dataset != nullptr)
+        if (BeginWindow("Dataset Editor", &m_visibleDatasetWindows) && m_dataset != nullptr)
         {
             auto numberOfColumns = m_dataset->vectorLength();
-            auto columnNames = m_dataset->getNames();
+            const auto &weightLabels = m_datasetViews.weightLabels;
 
             static float setAllValue{0};
             ImGui::InputFloat("Set all", &setAllValue);
@@ -148,9 +287,9 @@ namespace VSOMExplorer
 
             ImGui::Text("Columns:");
 
-            for (size_t currentColumn{0}; currentColumn < numberOfColumns; ++currentColumn)
+            for (size_t currentColumn{0}; currentColumn < numberOfColumns && currentColumn < weightLabels.size(); ++currentColumn)
             {
-                ImGui::InputFloat((columnNames[currentColumn] + " Weight").c_str(), &m_dataset->getWeight(currentColumn));
+                ImGui::InputFloat(weightLabels[currentColumn].c_str(), &m_dataset->getWeight(currentColumn));
             }
         }
         ImGui::End();
@@ -158,9 +297,13 @@ namespace VSOMExplorer
 
     void Handler::DatasetViewer()
     {
-        if (ImGui::Begin("Dataset") && m_dataset != nullptr)
-        { // TODO: Se till så att preview data hämtas när datasetet laddas
-            const static auto previewData = m_dataset->getPreviewData(100);
+        if (BeginWindow("Dataset", &m_visibleDatasetWindows) && m_dataset != nullptr)
+        {
+            /* Normally fetched by the workspace loader, datasets opened from the menu fetch it here */
+            m_memoryBudget.touch(m_previewCache);
+            if (!m_previewData)
+                m_previewData = m_dataset->getPreviewData(100);
+            const auto &previewData = *m_previewData;
             auto numberOfRows = m_dataset->size();
             numberOfRows = numberOfRows >= 100 ? 100 : numberOfRows;
 
@@ -172,20 +315,20 @@ namespace VSOMExplorer
                 const size_t width = modelVectorAsImageWidth, height = modelVectorAsImageWidth;
                 const size_t x_offset = 1, y_offset = 1, step_size = 2;
 
-                for (int n = 0; n < numberOfRows; ++n)
+                for (size_t n = 0; n < numberOfRows; ++n)
                 {
                     ImDrawList *draw_list = ImGui::GetWindowDrawList();
-                    auto currentNeuron = previewData[n];
+                    const auto &currentRow = previewData[n];
 
                     p.x += x_offset + width * step_size;
 
                     /* Draw actual image */
-                    for (size_t i{0}; i < currentNeuron.size(); ++i)
+                    for (size_t i{0}; i < static_cast<size_t>(currentRow.size()); ++i)
                     {
                         const size_t x = i % width * step_size + x_offset;
                         const size_t y = i / height * step_size + y_offset;
 
-                        auto currentValue = scaleColorToUCharRange(currentNeuron[i], 255.f, 0.f);
+                        auto currentValue = scaleToByte(currentRow[i], 0.f, 255.f);
 
                         draw_list->AddRectFilled(ImVec2(p.x + x, p.y + y),
                                                  ImVec2(p.x + x + step_size, p.y + y + step_size),
@@ -209,25 +352,25 @@ namespace VSOMExplorer
                 auto numberOfColumns = m_dataset->vectorLength();
                 numberOfColumns = numberOfColumns >= 64 ? 64 : numberOfColumns;
 
+                if (!m_datasetViews.hasPreviewText)
+                    m_datasetViews.formatPreview(previewData, std::min<size_t>(numberOfRows, previewData.size()), numberOfColumns);
+
                 if (ImGui::BeginTable("table1", numberOfColumns, flags))
                 {
                     if (display_headers)
                     {
                         for (size_t columnIndex{0}; columnIndex < numberOfColumns; ++columnIndex)
-                            ImGui::TableSetupColumn(m_dataset->getName(columnIndex).c_str());
+                            ImGui::TableSetupColumn(m_datasetViews.labels[columnIndex]);
                         ImGui::TableHeadersRow();
                     }
 
-                    for (size_t row{0}; row < numberOfRows; ++row)
+                    for (size_t row{0}; row < m_datasetViews.previewRows; ++row)
                     {
-                        auto rowValues = previewData[row];
                         ImGui::TableNextRow();
-                        for (size_t column{0}; column < numberOfColumns; ++column)
+                        for (size_t column{0}; column < m_datasetViews.previewColumns; ++column)
                         {
                             ImGui::TableSetColumnIndex(column);
-                            auto columnValue = rowValues[column];
-                            auto textValue = std::to_string(columnValue);
-                            ImGui::TextUnformatted(textValue.c_str());
+                            ImGui::TextUnformatted(m_datasetViews.previewCell(row, column));
                         }
                     }
                     ImGui::EndTable();
@@ -237,194 +380,379 @@ namespace VSOMExplorer
         ImGui::End();
     }
 
-    void Handler::RenderUMatrix()
+    void Handler::StartQuery()
     {
-        if (ImGui::Begin("U-matrix"))
-        {
-            auto uMatrix = m_som.getUMatrix();
-
-            auto xSteps = uMatrix.getWidth();
-            auto ySteps = uMatrix.getHeight();
-            auto xStepSize = ImGui::GetWindowWidth() / xSteps;
-            auto yStepSize = ImGui::GetWindowHeight() / ySteps;
-
-            auto maxValue = uMatrix.getMaxValue();
-
-            ImDrawList *draw_list = ImGui::GetWindowDrawList();
-
-            static float upper = 255.0f;
-            static float lower = 0.0f;
-            ImGui::DragFloat("Upper", &upper, 0.2f, 0.0f, 255.0f, "%.0f");
-            ImGui::DragFloat("Lower", &lower, 0.2f, 0.0f, 255.0f, "%.0f");
+        m_queryError.clear();
+        const auto depth = m_dataset->vectorLength();
 
-            const ImVec2 p = ImGui::GetCursorScreenPos();
+        m_memoryBudget.touch(m_trainingMatrixCache);
+        if (m_dataMatrix == nullptr)
+            m_dataMatrix = denseMatrix(m_dataLoader.get(), *m_dataset);
 
-            for (size_t yIndex{0}; yIndex < ySteps; ++yIndex)
+        auto query = std::vector<float>{};
+        auto excludedRow = noExcludedIndex;
+        if (m_queryByRow)
+        {
+            if (m_queryRow < 0 || static_cast<size_t>(m_queryRow) >= m_dataMatrix->size())
+            {
+                m_queryError = "No row " + std::to_string(m_queryRow);
+                return;
+            }
+            /* The row itself is not one of its neighbours */
+            excludedRow = static_cast<size_t>(m_queryRow);
+            const auto *row = m_dataMatrix->getRow(excludedRow);
+            query.assign(row, row + depth);
+        }
+        else
+        {
+            const auto *text = m_queryVector;
+            const auto *end = text + std::strlen(text);
+            while (text < end)
             {
-                for (size_t xIndex{0}; xIndex < xSteps; ++xIndex)
+                const auto *tokenEnd = std::find_if(text, end, [](char c)
+                                                    { return c == ',' || c == ';' || c == ' ' || c == '\t'; });
+                float value;
+                if (tokenEnd != text && !parseFloat(text, tokenEnd, &value))
                 {
-                    auto unscaledValue = uMatrix.getValueAtIndex(xIndex, yIndex);
-                    auto value = scaleColorToUCharRangeWithZoom(unscaledValue, maxValue, 0.f, static_cast<int>(upper), static_cast<int>(lower));
-
-                    draw_list->AddRectFilledMultiColor(ImVec2(p.x + xIndex * xStepSize, p.y + yIndex * yStepSize),
-                                                       ImVec2(p.x + (xIndex + 1) * xStepSize, p.y + (yIndex + 1) * yStepSize), IM_COL32(value, value, value, 255), IM_COL32(value, value, value, 255), IM_COL32(value, value, value, 255), IM_COL32(value, value, value, 255));
+                    m_queryError = "Could not read \"" + std::string(text, tokenEnd) + "\"";
+                    return;
                 }
+                if (tokenEnd != text)
+                    query.push_back(value);
+                text = tokenEnd != end ? tokenEnd + 1 : end;
+            }
+            if (query.size() != depth)
+            {
+                m_queryError = "Expected " + std::to_string(depth) + " values, got " + std::to_string(query.size());
+                return;
             }
         }
-        ImGui::End();
+
+        if (m_queryPool == nullptr)
+            m_queryPool = std::make_unique<ThreadPool>(std::max(1u, std::thread::hardware_concurrency()));
+
+        m_queryFuture = std::async(std::launch::async, [pool = m_queryPool.get(), data = m_dataMatrix, codebook = m_modelViews.codebook, weights = getDatasetWeights(),
+                                                        query = std::move(query), excludedRow, k = static_cast<size_t>(std::max(1, m_queryCount)), revision = m_modelViews.revision]()
+                                   {
+            const auto start = std::chrono::steady_clock::now();
+            auto result = QueryResult{};
+            result.revision = revision;
+            result.mapWidth = codebook.getWidth();
+            if (codebook.getDepth() == query.size())
+                result.neurons = nearestNeighbours(*pool, query.data(), codebook.getValues().data(), codebook.size(), query.size(), weights, k);
+            result.rows = nearestNeighbours(*pool, query.data(), data->getRow(0), data->size(), query.size(), weights, k, excludedRow);
+            result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return result; });
     }
 
-    void Handler::RenderWeigthMap()
+    void Handler::QueryViewer()
     {
-        if (ImGui::Begin("Weight Map"))
+        if (BeginWindow("Query", &m_visibleDatasetWindows) && m_dataset != nullptr)
         {
-            auto xSteps = m_som.getWidth();
-            auto ySteps = m_som.getHeight();
-            auto xStepSize = ImGui::GetWindowWidth() / xSteps;
-            auto yStepSize = ImGui::GetWindowHeight() / ySteps;
+            if (m_queryFuture.valid() && m_queryFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                m_queryResult = m_queryFuture.get();
 
-            auto weightMap = m_som.getWeigthMap();
-            auto maxValue = weightMap.maxCoeff();
+            if (ImGui::RadioButton("Row", m_queryByRow))
+                m_queryByRow = true;
+            ImGui::SameLine();
+            if (ImGui::RadioButton("Vector", !m_queryByRow))
+                m_queryByRow = false;
 
-            ImDrawList *draw_list = ImGui::GetWindowDrawList();
-
-            static float upper = 255.0f;
-            static float lower = 0.0f;
-            ImGui::DragFloat("Upper", &upper, 0.2f, 0.0f, 255.0f, "%.0f");
-            ImGui::DragFloat("Lower", &lower, 0.2f, 0.0f, 255.0f, "%.0f");
-
-            const ImVec2 p = ImGui::GetCursorScreenPos();
+            if (m_queryByRow)
+                ImGui::InputInt("Row id", &m_queryRow);
+            else
+            {
+                ImGui::InputText("Values", m_queryVector, sizeof(m_queryVector));
+                ImGui::TextDisabled("%zu values separated by commas or spaces", m_dataset->vectorLength());
+            }
+            ImGui::SliderInt("Neighbours", &m_queryCount, 1, 100);
 
-            for (size_t yIndex{0}; yIndex < ySteps; ++yIndex)
+            const auto searching = m_queryFuture.valid();
+            if (searching)
+                ImGui::BeginDisabled(true);
+            if (ImGui::Button("Find"))
+                StartQuery();
+            if (searching)
+                ImGui::EndDisabled();
+            ImGui::SameLine();
+            if (searching)
+                ImGui::TextUnformatted("Searching...");
+            else if (!m_queryError.empty())
+                ImGui::TextUnformatted(m_queryError.c_str());
+            else if (m_queryResult.revision != ModelViews::noGeneration)
+                ImGui::Text("%.2f ms%s", m_queryResult.milliseconds, m_queryResult.revision != m_modelViews.revision ? ", model has changed since" : "");
+
+            const auto &result = m_queryResult;
+            if (!result.neurons.empty() && ImGui::BeginTable("Neurons", 4, ImGuiTableFlags_RowBg))
             {
-                for (size_t xIndex{0}; xIndex < xSteps; ++xIndex)
+                ImGui::TableSetupColumn("Rank");
+                ImGui::TableSetupColumn("X");
+                ImGui::TableSetupColumn("Y");
+                ImGui::TableSetupColumn("Distance");
+                ImGui::TableHeadersRow();
+                for (size_t rank{0}; rank < result.neurons.size(); ++rank)
                 {
-                    auto unscaledValue = weightMap[yIndex * xSteps + xIndex];
-                    auto value = scaleColorToUCharRangeWithZoom(unscaledValue, maxValue, 0.f, static_cast<int>(upper), static_cast<int>(lower));
+                    const auto &neuron = result.neurons[rank];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%zu", rank + 1);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%zu", neuron.index % result.mapWidth);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%zu", neuron.index / result.mapWidth);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.4f", std::sqrt(neuron.distance));
+                }
+                ImGui::EndTable();
+            }
 
-                    draw_list->AddRectFilledMultiColor(ImVec2(p.x + xIndex * xStepSize, p.y + yIndex * yStepSize),
-                                                       ImVec2(p.x + (xIndex + 1) * xStepSize, p.y + (yIndex + 1) * yStepSize), IM_COL32(value, value, value, 255), IM_COL32(value, value, value, 255), IM_COL32(value, value, value, 255), IM_COL32(value, value, value, 255));
+            if (!result.rows.empty() && ImGui::BeginTable("Rows", 3, ImGuiTableFlags_RowBg))
+            {
+                ImGui::TableSetupColumn("Rank");
+                ImGui::TableSetupColumn("Row");
+                ImGui::TableSetupColumn("Distance");
+                ImGui::TableHeadersRow();
+                for (size_t rank{0}; rank < result.rows.size(); ++rank)
+                {
+                    const auto &row = result.rows[rank];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%zu", rank + 1);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%zu", row.index);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.4f", std::sqrt(row.distance));
                 }
+                ImGui::EndTable();
             }
         }
         ImGui::End();
     }
 
-    void Handler::RenderBmuHits()
+    void Handler::RenderUMatrix()
     {
-        if (ImGui::Begin("BMU Hits"))
+        if (BeginWindow("U-matrix", &m_visibleModelWindows))
         {
-            auto xSteps = m_som.getWidth();
-            auto ySteps = m_som.getHeight();
-            auto xStepSize = ImGui::GetWindowWidth() / xSteps;
-            auto yStepSize = ImGui::GetWindowHeight() / ySteps;
+            RenderValueGrid(m_modelViews.uMatrix, m_uMatrixRange, m_uMatrixHex);
+        }
+        ImGui::End();
+    }
 
-            auto bmuHits = m_som.getBmuHits();
-            auto maxValue = *std::max_element(bmuHits.begin(), bmuHits.end());
+    void Handler::RenderWeigthMap()
+    {
+        if (BeginWindow("Weight Map", &m_visibleModelWindows))
+        {
+            RenderValueGrid(m_modelViews.weightMap, m_weightMapRange, m_weightMapHex);
+        }
+        ImGui::End();
+    }
 
-            ImDrawList *draw_list = ImGui::GetWindowDrawList();
+    void Handler::RenderBmuHits()
+    {
+        if (BeginWindow("BMU Hits", &m_visibleModelWindows))
+        {
+            ImGui::Checkbox("Log scale", &m_bmuHitsLogScale);
+            RenderValueGrid(m_modelViews.bmuHits, m_bmuHitsRange, m_bmuHitsHex, m_bmuHitsLogScale);
+        }
+        ImGui::End();
+    }
 
-            static float upper = 255.0f;
-            static float lower = 0.0f;
-            ImGui::DragFloat("Upper", &upper, 0.2f, 0.0f, 255.0f, "%.0f");
-            ImGui::DragFloat("Lower", &lower, 0.2f, 0.0f, 255.0f, "%.0f");
+    void Handler::PollLabelMaps()
+    {
+        if (m_labelMapsFuture.valid() && m_labelMapsFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            m_labelMaps = m_labelMapsFuture.get();
+            m_labelMaps.updateLabels();
+        }
 
-            const ImVec2 p = ImGui::GetCursorScreenPos();
+        /* While training the codebook changes every frame, the counts are taken once it has settled */
+        const auto &codebook = m_modelViews.codebook;
+        if (m_labelMapsFuture.valid() || m_labelColumn == EpochSampler::noLabelColumn || isTraining() ||
+            isWorkspaceLoading() || codebook.getDepth() != m_dataset->vectorLength())
+            return;
+
+        const auto labelColumn = static_cast<size_t>(m_labelColumn);
+        auto current = m_labelMaps.matches(m_modelViews.revision, m_datasetGeneration, labelColumn) && m_labelMaps.weights.size() == m_dataset->vectorLength();
+        for (size_t column{0}; current && column < m_labelMaps.weights.size(); ++column)
+            current = m_labelMaps.weights[column] == m_dataset->getWeight(column);
+        if (current)
+            return;
+
+        m_memoryBudget.touch(m_trainingMatrixCache);
+        if (m_dataMatrix == nullptr)
+            m_dataMatrix = denseMatrix(m_dataLoader.get(), *m_dataset);
+
+        m_labelMapsFuture = std::async(std::launch::async, [data = m_dataMatrix, codebook, weights = getDatasetWeights(), searchMode = m_trainingParameters.searchMode,
+                                                            labelColumn, revision = m_modelViews.revision, datasetGeneration = m_datasetGeneration]()
+                                       {
+            auto maps = computeLabelMaps(codebook, *data, weights, searchMode, labelColumn);
+            maps.revision = revision;
+            maps.datasetGeneration = datasetGeneration;
+            return maps; });
+    }
 
-            for (size_t yIndex{0}; yIndex < ySteps; ++yIndex)
+    void Handler::LabelViewer()
+    {
+        if (BeginWindow("Labels", &m_visibleModelWindows) && m_dataset != nullptr)
+        {
+            const auto &labels = m_datasetViews.labels;
+            if (m_labelColumn >= static_cast<long>(labels.size()))
+                m_labelColumn = EpochSampler::noLabelColumn;
+            const auto *labelPreview = m_labelColumn == EpochSampler::noLabelColumn ? "None" : labels[m_labelColumn];
+            if (ImGui::BeginCombo("Label column", labelPreview))
             {
-                for (size_t xIndex{0}; xIndex < xSteps; ++xIndex)
+                if (ImGui::Selectable("None", m_labelColumn == EpochSampler::noLabelColumn))
+                    m_labelColumn = EpochSampler::noLabelColumn;
+                for (size_t column{0}; column < labels.size(); ++column)
                 {
-                    auto unscaledValue = bmuHits[yIndex * xSteps + xIndex];
-                    auto value = scaleColorToUCharRangeWithZoom(unscaledValue, maxValue, 0.f, static_cast<int>(upper), static_cast<int>(lower));
+                    if (ImGui::Selectable(labels[column], m_labelColumn == static_cast<long>(column)))
+                        m_labelColumn = static_cast<long>(column);
+                }
+                ImGui::EndCombo();
+            }
+
+            m_memoryBudget.touch(m_labelMapsCache);
+            PollLabelMaps();
+
+            const auto &maps = m_labelMaps;
+            const auto ready = m_labelColumn != EpochSampler::noLabelColumn && maps.labelColumn == static_cast<size_t>(m_labelColumn) &&
+                               maps.datasetGeneration == m_datasetGeneration;
+            if (m_labelColumn == EpochSampler::noLabelColumn)
+                ImGui::TextUnformatted("Pick the column holding each row's class");
+            else if (!ready)
+                ImGui::TextUnformatted("Counting labels...");
+            else if (maps.tooManyClasses)
+                ImGui::Text("More than %zu distinct values, this is not a label column", LabelMaps::maxClasses);
+            else if (!maps.classes.empty())
+            {
+                ImGui::Text("%zu classes, %zu unlabelled rows%s", maps.classes.size(), maps.unlabelledRows, m_labelMapsFuture.valid() ? ", updating..." : "");
+
+                auto layer = static_cast<size_t>(m_labelLayer);
+                RenderCombo("Layer", labelLayerNames, labelLayerCount, &layer, labelLayerNames[layer]);
+                m_labelLayer = static_cast<LabelLayer>(layer);
 
-                    draw_list->AddRectFilledMultiColor(ImVec2(p.x + xIndex * xStepSize, p.y + yIndex * yStepSize),
-                                                       ImVec2(p.x + (xIndex + 1) * xStepSize, p.y + (yIndex + 1) * yStepSize), IM_COL32(value, value, value, 255), IM_COL32(value, value, value, 255), IM_COL32(value, value, value, 255), IM_COL32(value, value, value, 255));
+                switch (m_labelLayer)
+                {
+                case LabelLayer::Majority:
+                {
+                    /* One hue per class, spread by the golden ratio so neighbouring labels differ */
+                    const auto neurons = maps.majority.size();
+                    auto *palette = m_frameArena.allocate<ImU32>(maps.classes.size());
+                    for (size_t label{0}; label < maps.classes.size(); ++label)
+                    {
+                        float red, green, blue;
+                        ImGui::ColorConvertHSVtoRGB(std::fmod(static_cast<float>(label) * 0.618034f, 1.f), 0.65f, 0.95f, red, green, blue);
+                        palette[label] = packColor(scaleToByte(red, 0.f, 1.f), scaleToByte(green, 0.f, 1.f), scaleToByte(blue, 0.f, 1.f));
+                    }
+                    auto *colors = m_frameArena.allocate<ImU32>(neurons);
+                    for (size_t neuron{0}; neuron < neurons; ++neuron)
+                        colors[neuron] = maps.majority[neuron] != LabelMaps::noClass ? palette[maps.majority[neuron]] : packColor(0, 0, 0);
+
+                    const auto xSteps = maps.purity.width;
+                    const auto ySteps = maps.purity.height;
+                    size_t hoverX{xSteps}, hoverY{ySteps};
+                    if (ImGui::BeginChild("LabelMap"))
+                        DrawMap(m_labelHex, colors, xSteps, ySteps, ImGui::GetContentRegionAvail(), &hoverX, &hoverY);
+                    ImGui::EndChild();
+
+                    if (ImGui::IsItemHovered() && hoverX < xSteps && hoverY < ySteps)
+                    {
+                        const auto neuron = hoverY * xSteps + hoverX;
+                        ImGui::BeginTooltip();
+                        if (maps.majority[neuron] == LabelMaps::noClass)
+                            ImGui::TextUnformatted("No rows");
+                        else
+                            ImGui::Text("Label %s\nPurity %.2f\nEntropy %.2f bits", maps.classLabels[maps.majority[neuron]], maps.purity.values[neuron], maps.entropy.values[neuron]);
+                        ImGui::EndTooltip();
+                    }
+                    break;
+                }
+                case LabelLayer::Purity:
+                    RenderValueGrid(maps.purity, m_labelRange, m_labelHex);
+                    break;
+                case LabelLayer::Entropy:
+                    RenderValueGrid(maps.entropy, m_labelRange, m_labelHex);
+                    break;
+                case LabelLayer::ClassHits:
+                    m_labelClass = std::min(m_labelClass, maps.classes.size() - 1);
+                    RenderCombo("Class", maps.classLabels, &m_labelClass);
+                    RenderValueGrid(maps.classHits[m_labelClass], m_labelRange, m_labelHex);
+                    break;
                 }
             }
+            else
+                ImGui::TextUnformatted("No row has a numeric label");
         }
         ImGui::End();
     }
 
-    void Handler::RenderMap()
+    void Handler::RenderFeatureCombos()
     {
-        if (ImGui::Begin("Map") && m_dataset != nullptr)
-        {
-            const auto featureNames = m_dataset->getNames();
-            // featureNames.push_back("None");
-            // const auto noneIndex = featureNames.size() - 1;
+        const auto &labels = m_datasetViews.labels;
+
+        RenderCombo("Red Value", labels, &m_currentRedColumnId);
+        RenderCombo("Green Value", labels, &m_currentGreenColumnId);
+        RenderCombo("Blue Value", labels, &m_currentBlueColumnId);
+    }
 
-            // m_currentRedColumnId = 0;
-            // m_currentGreenColumnId = 0;
-            // m_currentGreenColumnId = 0;
+    const ImU32 *Handler::RgbColors(const Codebook &codebook, ComponentPlanes &planes, const std::vector<float> &featureMin, const std::vector<float> &featureMax)
+    {
+        const auto neurons = codebook.size();
+        auto *colors = m_frameArena.allocate<ImU32>(neurons);
 
-            RenderCombo("Red Value", featureNames, &m_currentRedColumnId, m_dataset->getName(m_currentRedColumnId));
-            RenderCombo("Green Value", featureNames, &m_currentGreenColumnId, m_dataset->getName(m_currentGreenColumnId));
-            RenderCombo("Blue Value", featureNames, &m_currentBlueColumnId, m_dataset->getName(m_currentBlueColumnId));
+        const auto revision = m_modelViews.revision;
+        const auto *red = planes.get(codebook, revision, m_currentRedColumnId, featureMin[m_currentRedColumnId], featureMax[m_currentRedColumnId]);
+        const auto *green = planes.get(codebook, revision, m_currentGreenColumnId, featureMin[m_currentGreenColumnId], featureMax[m_currentGreenColumnId]);
+        const auto *blue = planes.get(codebook, revision, m_currentBlueColumnId, featureMin[m_currentBlueColumnId], featureMax[m_currentBlueColumnId]);
 
-            auto xSteps = m_som.getWidth();
-            auto ySteps = m_som.getHeight();
-            auto xStepSize = ImGui::GetContentRegionAvail().x / xSteps;
-            auto yStepSize = ImGui::GetContentRegionAvail().y / ySteps;
+        for (size_t index{0}; index < neurons; ++index)
+            colors[index] = packColor(red[index], green[index], blue[index]);
 
-            auto maxRedValue = m_som.getMaxValueOfFeature(m_currentRedColumnId);
-            auto minRedValue = m_som.getMinValueOfFeature(m_currentRedColumnId);
-            auto maxGreenValue = m_som.getMaxValueOfFeature(m_currentGreenColumnId);
-            auto minGreenValue = m_som.getMinValueOfFeature(m_currentGreenColumnId);
-            auto maxBlueValue = m_som.getMaxValueOfFeature(m_currentBlueColumnId);
-            auto minBlueValue = m_som.getMinValueOfFeature(m_currentBlueColumnId);
+        return colors;
+    }
 
-            size_t hoverNeuronX{0}, hoverNeuronY{0};
+    bool Handler::hasValidFeatureSelection() const
+    {
+        const auto depth = m_modelViews.codebook.getDepth();
+        return m_currentRedColumnId < depth && m_currentGreenColumnId < depth && m_currentBlueColumnId < depth;
+    }
 
-            if (ImGui::BeginChild("HoverMap"))
-            {
-                /* Hover neuron index */
-                hoverNeuronX = static_cast<size_t>((ImGui::GetMousePos().x - ImGui::GetCursorScreenPos().x - ImGui::GetScrollX()) / xStepSize);
-                hoverNeuronY = static_cast<size_t>((ImGui::GetMousePos().y - ImGui::GetCursorScreenPos().y - ImGui::GetScrollY()) / yStepSize);
+    void Handler::RenderMap()
+    {
+        if (BeginWindow("Map", &m_visibleModelWindows) && m_dataset != nullptr)
+        {
+            RenderFeatureCombos();
 
-                ImDrawList *draw_list = ImGui::GetWindowDrawList();
+            const auto &codebook = m_modelViews.codebook;
+            auto xSteps = codebook.getWidth();
+            auto ySteps = codebook.getHeight();
+            const auto size = ImGui::GetContentRegionAvail();
 
-                const ImVec2 p = ImGui::GetCursorScreenPos();
+            size_t hoverNeuronX{xSteps}, hoverNeuronY{ySteps};
 
-                for (size_t yIndex{0}; yIndex < ySteps; ++yIndex)
-                {
-                    for (size_t xIndex{0}; xIndex < xSteps; ++xIndex)
-                    {
-                        auto modelVector = m_som.getNeuron(SomIndex{xIndex, yIndex});
-
-                        auto redValue = modelVector[m_currentRedColumnId];
-                        auto greenValue = modelVector[m_currentGreenColumnId];
-                        auto blueValue = modelVector[m_currentBlueColumnId];
-
-                        auto constrainedRedValue = scaleColorToUCharRange(redValue, maxRedValue, minRedValue);
-                        auto constrainedGreenValue = scaleColorToUCharRange(greenValue, maxGreenValue, minGreenValue);
-                        auto constrainedBlueValue = scaleColorToUCharRange(blueValue, maxBlueValue, minBlueValue);
-
-                        draw_list->AddRectFilledMultiColor(ImVec2(p.x + xIndex * xStepSize, p.y + yIndex * yStepSize),
-                                                           ImVec2(p.x + (xIndex + 1) * xStepSize, p.y + (yIndex + 1) * yStepSize),
-                                                           IM_COL32(constrainedRedValue, constrainedGreenValue, constrainedBlueValue, 255),
-                                                           IM_COL32(constrainedRedValue, constrainedGreenValue, constrainedBlueValue, 255),
-                                                           IM_COL32(constrainedRedValue, constrainedGreenValue, constrainedBlueValue, 255),
-                                                           IM_COL32(constrainedRedValue, constrainedGreenValue, constrainedBlueValue, 255));
-                    }
-                }
+            if (ImGui::BeginChild("HoverMap") && hasValidFeatureSelection())
+            {
+                m_memoryBudget.touch(m_componentPlanesCache);
+                const auto *colors = RgbColors(codebook, m_componentPlanes, m_modelViews.featureMin, m_modelViews.featureMax);
+                const auto origin = ImGui::GetCursorScreenPos();
+                DrawMap(m_mapHex, colors, xSteps, ySteps, size, &hoverNeuronX, &hoverNeuronY);
+                DrawQueryHighlights(m_mapHex, xSteps, ySteps, origin, size);
             }
 
             ImGui::EndChild();
 
             /* Display model vector values in tooltip */
-            if (ImGui::IsItemHovered())
+            if (ImGui::IsItemHovered() && hoverNeuronX < xSteps && hoverNeuronY < ySteps)
             {
-                auto currentNeuron = m_som.getNeuron(m_som.getIndex(SomIndex{hoverNeuronX, hoverNeuronY}));
+                const auto *currentNeuron = codebook.getNeuron(codebook.getIndex(hoverNeuronX, hoverNeuronY));
+                const auto depth = std::min(codebook.getDepth(), m_datasetViews.names.size());
 
                 if (!showModelVectorsAsImage)
                 {
                     ImGui::BeginTooltip();
-                    for (size_t i{0}; i < currentNeuron.size(); ++i)
+                    for (size_t i{0}; i < depth; ++i)
                     {
-                        auto featureName = m_dataset->getName(i).c_str();
-
-                        ImGui::Text("%s:\t%.3f", featureName, currentNeuron[i]);
+                        ImGui::Text("%s:\t%.3f", m_datasetViews.labels[i], currentNeuron[i]);
                     }
                     ImGui::EndTooltip();
                 }
@@ -432,7 +760,7 @@ namespace VSOMExplorer
                 {
                     ImDrawList *draw_list = ImGui::GetForegroundDrawList();
 
-                    for (size_t i{0}; i < currentNeuron.size(); ++i)
+                    for (size_t i{0}; i < codebook.getDepth(); ++i)
                     {
                         const ImVec2 p = ImGui::GetMousePos();
 
@@ -441,7 +769,7 @@ namespace VSOMExplorer
                         const size_t x = i % width * 2 + x_offset;
                         const size_t y = i / height * 2 + y_offset;
 
-                        auto currentValue = scaleColorToUCharRange(currentNeuron[i], 255.f, 0.f);
+                        auto currentValue = scaleToByte(currentNeuron[i], 0.f, 255.f);
 
                         draw_list->AddRectFilled(ImVec2(p.x + x, p.y + y),
                                                  ImVec2(p.x + x + 2, p.y + y + 2),
@@ -455,84 +783,40 @@ namespace VSOMExplorer
 
     void Handler::RenderSigmaMap()
     {
-        if (ImGui::Begin("Sigma Map") && m_dataset != nullptr)
+        if (BeginWindow("Sigma Map", &m_visibleModelWindows) && m_dataset != nullptr)
         {
-            auto featureNames = m_dataset->getNames();
-            // featureNames.push_back("None");
-            // const auto noneIndex = featureNames.size() - 1;
-
-            // m_currentRedColumnId = 0;
-            // m_currentGreenColumnId = 0;
-            // m_currentGreenColumnId = 0;
-
-            RenderCombo("Red Value", featureNames, &m_currentRedColumnId, m_dataset->getName(m_currentRedColumnId));
-            RenderCombo("Green Value", featureNames, &m_currentGreenColumnId, m_dataset->getName(m_currentGreenColumnId));
-            RenderCombo("Blue Value", featureNames, &m_currentBlueColumnId, m_dataset->getName(m_currentBlueColumnId));
-
-            auto xSteps = m_som.getWidth();
-            auto ySteps = m_som.getHeight();
-            auto xStepSize = ImGui::GetWindowWidth() / xSteps;
-            auto yStepSize = ImGui::GetWindowHeight() / ySteps;
+            RenderFeatureCombos();
 
-            auto maxRedValue = m_som.getMaxSigmaOfFeature(m_currentRedColumnId);
-            auto minRedValue = m_som.getMinSigmaOfFeature(m_currentRedColumnId);
-            auto maxGreenValue = m_som.getMaxSigmaOfFeature(m_currentGreenColumnId);
-            auto minGreenValue = m_som.getMinSigmaOfFeature(m_currentGreenColumnId);
-            auto maxBlueValue = m_som.getMaxSigmaOfFeature(m_currentBlueColumnId);
-            auto minBlueValue = m_som.getMinSigmaOfFeature(m_currentBlueColumnId);
+            const auto &codebook = m_modelViews.codebook;
+            const auto &sigma = m_modelViews.sigma;
+            auto xSteps = sigma.getWidth();
+            auto ySteps = sigma.getHeight();
+            const auto size = m_hexagonalTopology ? ImGui::GetContentRegionAvail() : ImVec2(ImGui::GetWindowWidth(), ImGui::GetWindowHeight());
 
-            size_t hoverNeuronX{0}, hoverNeuronY{0};
+            size_t hoverNeuronX{xSteps}, hoverNeuronY{ySteps};
 
-            if (ImGui::BeginChild("HoverSigmaMap"))
+            if (ImGui::BeginChild("HoverSigmaMap") && hasValidFeatureSelection())
             {
-                /* Hover neuron index */
-                hoverNeuronX = static_cast<size_t>((ImGui::GetMousePos().x - ImGui::GetCursorScreenPos().x - ImGui::GetScrollX()) / xStepSize);
-                hoverNeuronY = static_cast<size_t>((ImGui::GetMousePos().y - ImGui::GetCursorScreenPos().y - ImGui::GetScrollY()) / yStepSize);
-
-                ImDrawList *draw_list = ImGui::GetWindowDrawList();
-
-                const ImVec2 p = ImGui::GetCursorScreenPos();
-
-                for (size_t yIndex{0}; yIndex < ySteps; ++yIndex)
-                {
-                    for (size_t xIndex{0}; xIndex < xSteps; ++xIndex)
-                    {
-                        auto modelVector = m_som.getSigmaNeuron(SomIndex{xIndex, yIndex});
-
-                        auto redValue = modelVector[m_currentRedColumnId];
-                        auto greenValue = modelVector[m_currentGreenColumnId];
-                        auto blueValue = modelVector[m_currentBlueColumnId];
-
-                        auto constrainedRedValue = scaleColorToUCharRange(redValue, maxRedValue, minRedValue);
-                        auto constrainedGreenValue = scaleColorToUCharRange(greenValue, maxGreenValue, minGreenValue);
-                        auto constrainedBlueValue = scaleColorToUCharRange(blueValue, maxBlueValue, minBlueValue);
-
-                        draw_list->AddRectFilledMultiColor(ImVec2(p.x + xIndex * xStepSize, p.y + yIndex * yStepSize),
-                                                           ImVec2(p.x + (xIndex + 1) * xStepSize, p.y + (yIndex + 1) * yStepSize),
-                                                           IM_COL32(constrainedRedValue, constrainedGreenValue, constrainedBlueValue, 255),
-                                                           IM_COL32(constrainedRedValue, constrainedGreenValue, constrainedBlueValue, 255),
-                                                           IM_COL32(constrainedRedValue, constrainedGreenValue, constrainedBlueValue, 255),
-                                                           IM_COL32(constrainedRedValue, constrainedGreenValue, constrainedBlueValue, 255));
-                    }
-                }
+                m_memoryBudget.touch(m_sigmaPlanesCache);
+                const auto *colors = RgbColors(sigma, m_sigmaPlanes, m_modelViews.sigmaMin, m_modelViews.sigmaMax);
+                DrawMap(m_sigmaHex, colors, xSteps, ySteps, size, &hoverNeuronX, &hoverNeuronY);
             }
             ImGui::EndChild();
 
             /* Display model vector values in tooltip */
-            if (ImGui::IsItemHovered())
+            if (ImGui::IsItemHovered() && hoverNeuronX < xSteps && hoverNeuronY < ySteps && codebook.size() == sigma.size())
             {
-                auto index = SomIndex{hoverNeuronX, hoverNeuronY};
-                auto currentNeuron = m_som.getNeuron(index);
-                auto currentNeuronSigma = m_som.getSigmaNeuron(index);
+                const auto index = codebook.getIndex(hoverNeuronX, hoverNeuronY);
+                const auto *currentNeuron = codebook.getNeuron(index);
+                const auto *currentNeuronSigma = sigma.getNeuron(index);
+                const auto depth = std::min(codebook.getDepth(), m_datasetViews.names.size());
 
                 if (!showModelVectorsAsImage)
                 {
                     ImGui::BeginTooltip();
-                    for (size_t i{0}; i < currentNeuron.size(); ++i)
+                    for (size_t i{0}; i < depth; ++i)
                     {
-                        auto featureName = m_dataset->getName(i).c_str();
-
-                        ImGui::Text("%s:\t%.3f +- %.3f", featureName, currentNeuron[i], currentNeuronSigma[i]);
+                        ImGui::Text("%s:\t%.3f +- %.3f", m_datasetViews.labels[i], currentNeuron[i], currentNeuronSigma[i]);
                     }
                     ImGui::EndTooltip();
                 }
@@ -540,7 +824,7 @@ namespace VSOMExplorer
                 {
                     ImDrawList *draw_list = ImGui::GetForegroundDrawList();
 
-                    for (size_t i{0}; i < currentNeuron.size(); ++i)
+                    for (size_t i{0}; i < sigma.getDepth(); ++i)
                     {
                         const ImVec2 p = ImGui::GetMousePos();
 
@@ -549,7 +833,7 @@ namespace VSOMExplorer
                         const size_t x = i % width * 2 + x_offset;
                         const size_t y = i / height * 2 + y_offset;
 
-                        auto currentValue = scaleColorToUCharRange(currentNeuronSigma[i], 255.f, 0.f);
+                        auto currentValue = scaleToByte(currentNeuronSigma[i], 0.f, 255.f);
 
                         draw_list->AddRectFilled(ImVec2(p.x + x, p.y + y),
                                                  ImVec2(p.x + x + 2, p.y + y + 2),
@@ -563,51 +847,132 @@ namespace VSOMExplorer
 
     void Handler::SomHandler()
     {
-        static std::thread trainingThread;
-        auto currentlyTraining = m_som.isTraining();
+        auto currentlyTraining = isTraining();
         if (ImGui::Begin("SOM"))
         {
             if (currentlyTraining)
                 ImGui::BeginDisabled(true);
             {
-                static int width = m_som.getWidth();
-                static int height = m_som.getHeight();
                 ImGui::Text("SOM");
-                ImGui::InputInt("Width", &width);
-                ImGui::InputInt("Height", &height);
+                ImGui::InputInt("Width", &m_somWidth);
+                ImGui::InputInt("Height", &m_somHeight);
                 if (ImGui::Button("Create") && m_dataset != nullptr)
-                    m_som = Som(width, height, m_dataset->vectorLength());
-                static float initSigma = 1.0f;
-                ImGui::InputFloat("Init variance", &initSigma);
+                {
+                    m_som = Som(m_somWidth, m_somHeight, m_dataset->vectorLength());
+                    ResetHistory();
+                    ++m_modelGeneration;
+                }
+                ImGui::InputFloat("Init variance", &m_initSigma);
+                ImGui::InputInt("Seed", &m_seed);
                 if (ImGui::Button("Randomly initialize"))
-                    m_som.randomInitialize((unsigned)(time(NULL) + clock()), initSigma);
+                {
+                    m_som.randomInitialize(static_cast<unsigned>(m_seed), m_initSigma);
+                    ++m_modelGeneration;
+                }
 
-                static int numberOfEpochs = 100;
-                static double eta0 = 0.9;
-                static double etaDecay = 0.01;
-                static double sigma0 = 10;
-                static double sigmaDecay = 0.01;
+                auto &parameters = m_trainingParameters;
 
                 // ImGui::InputInt("Number of epochs", numberOfEpochs);
-                static int elem = static_cast<std::underlying_type_t<Som::WeigthDecayFunction>>(Som::WeigthDecayFunction::Exponential);
+                int elem = static_cast<std::underlying_type_t<Som::WeigthDecayFunction>>(parameters.decayFunction);
                 const char *elems_names[3] = {"Exponential", "Inverse proportional", "Batch Map"};
                 const char *elem_name = (elem >= 0 && elem < 3) ? elems_names[elem] : "Unknown";
-                ImGui::SliderInt("Weight decay function", &elem, 0, 2, elem_name);
+                if (ImGui::SliderInt("Weight decay function", &elem, 0, 2, elem_name))
+                    parameters.decayFunction = static_cast<Som::WeigthDecayFunction>(elem);
 
-                ImGui::SliderInt("Number of epochs", &numberOfEpochs, 1, 1000);
+                int numberOfEpochs = static_cast<int>(parameters.numberOfEpochs);
+                if (ImGui::SliderInt("Number of epochs", &numberOfEpochs, 1, 1000))
+                    parameters.numberOfEpochs = static_cast<size_t>(numberOfEpochs);
                 if (elem == 0)
                 {
-                    ImGui::InputDouble("Eta0", &eta0);
-                    ImGui::InputDouble("Eta decay", &etaDecay);
+                    ImGui::InputDouble("Eta0", &parameters.eta0);
+                    ImGui::InputDouble("Eta decay", &parameters.etaDecay);
                 }
-                ImGui::InputDouble("Sigma0", &sigma0);
-                ImGui::InputDouble("Sigma decay", &sigmaDecay);
+                ImGui::InputDouble("Sigma0", &parameters.sigma0);
+                ImGui::InputDouble("Sigma decay", &parameters.sigmaDecay);
                 // #include <type_traits>
 
-                if (ImGui::Button("Train") && m_dataset != nullptr)
+                /* Anything but sequential exhaustive search trains with the in-app trainer */
+                auto searchMode = static_cast<size_t>(parameters.searchMode);
+                const char *searchModeNames[3] = {"Exhaustive", "Hierarchical", "Local"};
+                RenderCombo("BMU search", searchModeNames, 3, &searchMode, searchModeNames[searchMode]);
+                parameters.searchMode = static_cast<BmuSearchMode>(searchMode);
+
+                /* Only Batch Map epochs are split across threads, online updates depend on the previous sample */
+                int threads = static_cast<int>(parameters.threads);
+                const auto maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+                if (ImGui::SliderInt("Threads", &threads, 1, maxThreads))
+                    parameters.threads = static_cast<size_t>(threads);
+                if (parameters.threads > 1 && parameters.decayFunction != Som::WeigthDecayFunction::BatchMap)
+                    ImGui::TextDisabled("Parallel training applies to Batch Map only");
+
+                auto sampling = static_cast<size_t>(parameters.sampling);
+                const char *samplingNames[3] = {"Full", "Random fraction", "Fixed size"};
+                RenderCombo("Epoch sampling", samplingNames, 3, &sampling, samplingNames[sampling]);
+                parameters.sampling = static_cast<EpochSampling>(sampling);
+
+                if (parameters.sampling != EpochSampling::Full)
+                {
+                    if (parameters.sampling == EpochSampling::Fraction)
+                    {
+                        auto fraction = static_cast<float>(parameters.sampleFraction);
+                        if (ImGui::SliderFloat("Sample fraction", &fraction, 0.001f, 1.0f, "%.3f", ImGuiSliderFlags_Logarithmic))
+                            parameters.sampleFraction = fraction;
+                    }
+                    else
+                    {
+                        int sampleSize = static_cast<int>(parameters.sampleSize);
+                        if (ImGui::InputInt("Sample size", &sampleSize, 100, 1000))
+                            parameters.sampleSize = static_cast<size_t>(std::max(1, sampleSize));
+                    }
+
+                    /* Stratifying keeps rare classes in every epoch */
+                    const auto &labels = m_datasetViews.labels;
+                    if (parameters.labelColumn >= static_cast<long>(labels.size()))
+                        parameters.labelColumn = EpochSampler::noLabelColumn;
+                    const auto *labelPreview = parameters.labelColumn == EpochSampler::noLabelColumn ? "None" : labels[parameters.labelColumn];
+                    if (ImGui::BeginCombo("Stratify on", labelPreview))
+                    {
+                        if (ImGui::Selectable("None", parameters.labelColumn == EpochSampler::noLabelColumn))
+                            parameters.labelColumn = EpochSampler::noLabelColumn;
+                        for (size_t column{0}; column < labels.size(); ++column)
+                        {
+                            if (ImGui::Selectable(labels[column], parameters.labelColumn == static_cast<long>(column)))
+                                parameters.labelColumn = static_cast<long>(column);
+                        }
+                        ImGui::EndCombo();
+                    }
+
+                    ImGui::Checkbox("Final full pass", &parameters.finalFullPass);
+                }
+
+                /* A workspace still loading would replace the model and the dataset under the new thread */
+                if (ImGui::Button("Train") && m_dataset != nullptr && !isWorkspaceLoading())
                 {
-                    trainingThread = std::thread(&Som::train, std::ref(m_som), std::ref(*m_dataset), static_cast<size_t>(numberOfEpochs), eta0, etaDecay, sigma0, sigmaDecay, static_cast<Som::WeigthDecayFunction>(elem), true);
-                    trainingThread.detach();
+                    ResetHistory();
+                    if (!needsInAppTrainer(parameters))
+                    {
+                        {
+                            const std::lock_guard<std::mutex> lock(m_som.metricsMutex);
+                            m_historyEpochBase = m_som.getMetrics().MeanSquaredError.size();
+                        }
+                        m_history.record(0, Codebook::fromSom(m_som));
+                        if (m_somTrainingThread.joinable())
+                            m_somTrainingThread.join();
+                        m_somTraining = true;
+                        m_somTrainingThread = std::thread([this, parameters]()
+                                                          {
+                            m_som.train(*m_dataset, parameters.numberOfEpochs, parameters.eta0, parameters.etaDecay, parameters.sigma0, parameters.sigmaDecay, parameters.decayFunction, true);
+                            m_somTraining = false; });
+                    }
+                    else
+                    {
+                        m_memoryBudget.touch(m_trainingMatrixCache);
+                        if (m_dataMatrix == nullptr)
+                            m_dataMatrix = denseMatrix(m_dataLoader.get(), *m_dataset);
+
+                        parameters.seed = static_cast<unsigned>(m_seed);
+                        m_trainer.start(m_som, m_dataMatrix, getDatasetWeights(), parameters);
+                    }
                 }
                 if (currentlyTraining)
                 {
@@ -627,9 +992,262 @@ namespace VSOMExplorer
         {
             {
                 const std::lock_guard<std::mutex> lock(m_som.metricsMutex);
-                auto metrics = m_som.getMetrics();
-                auto maxValue = std::max_element(metrics.MeanSquaredError.begin(), metrics.MeanSquaredError.end());
-                ImGui::PlotLines("Mean Squared Training Error", metrics.MeanSquaredError.data(), metrics.MeanSquaredError.size(), 0, nullptr, 0.0f, *maxValue, ImVec2(0, 80.0f));
+                const auto &metrics = m_som.getMetrics();
+                if (!metrics.MeanSquaredError.empty())
+                {
+                    auto maxValue = std::max_element(metrics.MeanSquaredError.begin(), metrics.MeanSquaredError.end());
+                    ImGui::PlotLines("Mean Squared Training Error", metrics.MeanSquaredError.data(), metrics.MeanSquaredError.size(), 0, nullptr, 0.0f, *maxValue, ImVec2(0, 80.0f));
+                }
+            }
+            {
+                const std::lock_guard<std::mutex> lock(m_trainer.metricsMutex);
+                const auto &metrics = m_trainer.getMetrics();
+                if (!metrics.MeanSquaredError.empty())
+                {
+                    auto maxValue = std::max_element(metrics.MeanSquaredError.begin(), metrics.MeanSquaredError.end());
+                    ImGui::PlotLines("Mean Squared Training Error (accelerated)", metrics.MeanSquaredError.data(), metrics.MeanSquaredError.size(), 0, nullptr, 0.0f, *maxValue, ImVec2(0, 80.0f));
+                    ImGui::PlotLines("BMU search recall", metrics.BmuRecall.data(), metrics.BmuRecall.size(), 0, nullptr, 0.0f, 1.0f, ImVec2(0, 80.0f));
+                    ImGui::Text("Last epoch BMU recall: %.3f", metrics.BmuRecall.back());
+                    ImGui::PlotLines("Speedup", metrics.Speedup.data(), metrics.Speedup.size(), 0, nullptr, 0.0f, static_cast<float>(metrics.Threads), ImVec2(0, 80.0f));
+                    ImGui::Text("Last epoch: %.3f s, %.2fx speedup on %zu threads", metrics.EpochSeconds.back(), metrics.Speedup.back(), metrics.Threads);
+                    ImGui::Text("Last epoch trained on %zu of %zu rows", metrics.LastEpochRows, metrics.Rows);
+                }
+            }
+        }
+        ImGui::End();
+    }
+
+    void Handler::RegisterCaches()
+    {
+        m_componentPlanesCache = m_memoryBudget.add(
+            "Component planes", [this]()
+            { return m_componentPlanes.memoryBytes(); },
+            [this]()
+            {
+                m_componentPlanes.clear();
+                return true;
+            });
+        m_sigmaPlanesCache = m_memoryBudget.add(
+            "Sigma planes", [this]()
+            { return m_sigmaPlanes.memoryBytes(); },
+            [this]()
+            {
+                m_sigmaPlanes.clear();
+                return true;
+            });
+
+        /* Dense copy of the dataset the in-app trainer projects onto the map, rebuilt on the next Train.
+           A matrix shared with the loader frees nothing when dropped, so it is neither counted nor evicted. */
+        m_trainingMatrixCache = m_memoryBudget.add(
+            "Training matrix", [this]()
+            { return ownsTrainingMatrix() ? m_dataMatrix->memoryBytes() : size_t{0}; },
+            [this]()
+            {
+                if (!ownsTrainingMatrix() || isTraining() || isWorkspaceLoading())
+                    return false;
+                m_dataMatrix.reset();
+                return true;
+            });
+        m_previewCache = m_memoryBudget.add(
+            "Dataset preview", [this]()
+            {
+                auto bytes = m_datasetViews.previewBytes();
+                if (m_previewData)
+                {
+                    for (const auto &row : *m_previewData)
+                        bytes += static_cast<size_t>(row.size()) * sizeof(float);
+                }
+                return bytes; },
+            [this]()
+            {
+                if (isWorkspaceLoading())
+                    return false;
+                m_previewData.reset();
+                m_datasetViews.clearPreview();
+                return true;
+            });
+        m_hexCache = m_memoryBudget.add(
+            "Hex geometry", [this]()
+            { return m_uMatrixHex.memoryBytes() + m_weightMapHex.memoryBytes() + m_bmuHitsHex.memoryBytes() + m_mapHex.memoryBytes() + m_sigmaHex.memoryBytes() + m_labelHex.memoryBytes(); },
+            [this]()
+            {
+                for (auto *hex : {&m_uMatrixHex, &m_weightMapHex, &m_bmuHitsHex, &m_mapHex, &m_sigmaHex, &m_labelHex})
+                    hex->clear();
+                return true;
+            });
+        m_labelMapsCache = m_memoryBudget.add(
+            "Label maps", [this]()
+            { return m_labelMaps.memoryBytes(); },
+            [this]()
+            {
+                m_labelMaps = LabelMaps{};
+                return true;
+            });
+    }
+
+    void Handler::MemoryViewer()
+    {
+        if (ImGui::Begin("Memory"))
+        {
+            auto row = [](const char *name, size_t bytes)
+            {
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::TextUnformatted(name);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.1f KB", static_cast<double>(bytes) / 1024.0);
+            };
+
+            /* libsom keeps its own copies, estimated from the cached codebook instead of the live model */
+            const auto &codebook = m_modelViews.codebook;
+            const auto somBytes = codebook.getWidth() * codebook.getHeight() * codebook.getDepth() * sizeof(float);
+            const auto datasetBytes = m_dataset != nullptr ? m_dataset->size() * m_dataset->vectorLength() * sizeof(float) : size_t{0};
+            const auto &fonts = *ImGui::GetIO().Fonts;
+            const auto textureBytes = static_cast<size_t>(fonts.TexWidth) * static_cast<size_t>(fonts.TexHeight) * 4;
+
+            if (ImGui::BeginTable("Components", 2, ImGuiTableFlags_RowBg))
+            {
+                row("Dataset columns (estimated)", datasetBytes);
+                row("Codebook", somBytes + m_modelViews.codebook.memoryBytes());
+                row("Sigma", somBytes + m_modelViews.sigma.memoryBytes());
+                row("BMU hits", m_modelViews.bmuHits.memoryBytes());
+                row("U-matrix", m_modelViews.uMatrix.memoryBytes());
+                row("Weight map", m_modelViews.weightMap.memoryBytes());
+                row("Frame arena", m_frameArena.capacity());
+                row("Training history", m_history.memoryBytes());
+                row("GPU textures (font atlas)", textureBytes);
+                ImGui::EndTable();
+            }
+
+            ImGui::Separator();
+            ImGui::Text("Caches");
+
+            int budgetMegabytes = static_cast<int>(m_memoryBudget.getBudget() / (1024 * 1024));
+            if (ImGui::InputInt("Budget (MB, 0 = unlimited)", &budgetMegabytes))
+                m_memoryBudget.setBudget(static_cast<size_t>(std::max(0, budgetMegabytes)) * 1024 * 1024);
+
+            if (ImGui::BeginTable("Caches", 4, ImGuiTableFlags_RowBg))
+            {
+                ImGui::TableSetupColumn("Cache");
+                ImGui::TableSetupColumn("Size");
+                ImGui::TableSetupColumn("Last used");
+                ImGui::TableSetupColumn("Evictions");
+                ImGui::TableHeadersRow();
+
+                for (const auto &cache : m_memoryBudget.getCaches())
+                {
+                    row(cache.name.c_str(), cache.bytes());
+                    ImGui::TableNextColumn();
+                    if (cache.lastUse == 0)
+                        ImGui::TextUnformatted("never");
+                    else
+                        ImGui::Text("%zu frames ago", m_memoryBudget.getFrame() - cache.lastUse);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%zu", cache.evictions);
+                }
+                ImGui::EndTable();
+            }
+
+            ImGui::Text("Total cached: %.1f KB", static_cast<double>(m_memoryBudget.totalBytes()) / 1024.0);
+        }
+        ImGui::End();
+    }
+
+    void Handler::ResetHistory()
+    {
+        /* Not waiting for a decode in flight, its BMU pass over the dataset would stall the frame */
+        ++m_historyResets;
+        m_history.clear();
+        m_historyEpochBase = 0;
+        m_lastRecordedEpoch = 0;
+        m_historyShown = ModelViews::noGeneration;
+        if (m_historyEpoch)
+        {
+            m_historyEpoch.reset();
+            ++m_modelGeneration;
+        }
+    }
+
+    void Handler::StartHistoryDecode(size_t epoch)
+    {
+        auto weights = m_dataset != nullptr ? getDatasetWeights() : std::vector<float>{};
+        const auto searchMode = m_trainingParameters.searchMode;
+
+        m_historyFuture = std::async(std::launch::async, [this, epoch, reset = m_historyResets, data = m_dataMatrix, weights = std::move(weights), searchMode]()
+                                     {
+            auto frame = HistoryFrame{epoch, reset};
+            auto codebook = m_history.decode(epoch);
+            if (!codebook)
+                return frame;
+
+            frame.uMatrix = MapRaster::computeUMatrix(*codebook);
+            if (data != nullptr && data->vectorLength() == codebook->getDepth() && weights.size() == codebook->getDepth())
+                frame.bmuHits = MapRaster::computeBmuHits(*codebook, *data, weights, searchMode);
+            frame.codebook = std::move(*codebook);
+            return frame; });
+    }
+
+    void Handler::PollHistory()
+    {
+        if (m_historyFuture.valid() && m_historyFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            auto frame = m_historyFuture.get();
+            if (m_historyEpoch && frame.reset == m_historyResets && frame.epoch == *m_historyEpoch && !frame.codebook.empty())
+            {
+                m_modelViews.showSnapshot(std::move(frame.codebook), std::move(frame.uMatrix), std::move(frame.bmuHits));
+                m_historyShown = frame.epoch;
+            }
+        }
+
+        /* An evicted selection moves on to the oldest snapshot left */
+        if (m_historyEpoch && m_history.size() > 0)
+            m_historyEpoch = m_history.epochAt(m_history.indexOf(*m_historyEpoch));
+
+        /* One decode at a time, a slider dragged past several snapshots only decodes where it stops */
+        if (!m_historyFuture.valid() && m_historyEpoch && m_historyShown != *m_historyEpoch)
+            StartHistoryDecode(*m_historyEpoch);
+    }
+
+    void Handler::HistoryViewer()
+    {
+        if (ImGui::Begin("History"))
+        {
+            auto enabled = m_history.isEnabled();
+            if (ImGui::Checkbox("Record while training", &enabled))
+                m_history.setEnabled(enabled);
+
+            int interval = static_cast<int>(m_history.getInterval());
+            if (ImGui::InputInt("Every N epochs", &interval))
+                m_history.setInterval(static_cast<size_t>(std::max(1, interval)));
+
+            int capMegabytes = static_cast<int>(m_history.getMemoryCap() / (1024 * 1024));
+            if (ImGui::InputInt("Memory cap (MB)", &capMegabytes))
+                m_history.setMemoryCap(static_cast<size_t>(std::max(1, capMegabytes)) * 1024 * 1024);
+
+            const auto snapshots = m_history.size();
+            ImGui::Text("%zu snapshots, %.1f MB compressed from %.1f MB", snapshots,
+                        static_cast<double>(m_history.memoryBytes()) / (1024.0 * 1024.0),
+                        static_cast<double>(m_history.rawBytes()) / (1024.0 * 1024.0));
+
+            if (snapshots > 0)
+            {
+                int index = static_cast<int>(m_historyEpoch ? m_history.indexOf(*m_historyEpoch) : snapshots - 1);
+                if (ImGui::SliderInt("Snapshot", &index, 0, static_cast<int>(snapshots - 1)))
+                    m_historyEpoch = m_history.epochAt(static_cast<size_t>(index));
+                ImGui::SameLine();
+                ImGui::Text("epoch %zu", m_history.epochAt(static_cast<size_t>(index)));
+
+                if (ImGui::Button("Live") && m_historyEpoch)
+                {
+                    m_historyEpoch.reset();
+                    m_historyShown = ModelViews::noGeneration;
+                    ++m_modelGeneration;
+                }
+                ImGui::SameLine();
+                if (m_historyEpoch && m_historyShown != *m_historyEpoch)
+                    ImGui::TextUnformatted("Decoding...");
+                else
+                    ImGui::TextUnformatted(m_historyEpoch ? "Showing snapshot" : "Showing live model");
             }
         }
         ImGui::End();
@@ -641,6 +1259,15 @@ namespace VSOMExplorer
         {
             ImGui::Text("Display");
             ImGui::Checkbox("Show model vectors as image", &showModelVectorsAsImage);
+            ImGui::Checkbox("Hexagonal topology", &m_hexagonalTopology);
+
+            auto colormap = static_cast<size_t>(m_colormap.getName());
+            auto fineColormap = m_colormap.getEntries() == Colormap::fineEntries;
+            RenderCombo("Colormap", colormapNames, colormapCount, &colormap, colormapNames[colormap]);
+            ImGui::Checkbox("Fine colormap (4096 entries)", &fineColormap);
+            const auto entries = fineColormap ? Colormap::fineEntries : Colormap::coarseEntries;
+            if (static_cast<ColormapName>(colormap) != m_colormap.getName() || entries != m_colormap.getEntries())
+                m_colormap = Colormap(static_cast<ColormapName>(colormap), entries);
 
             if (showModelVectorsAsImage)
             {
@@ -651,22 +1278,343 @@ namespace VSOMExplorer
                 modelVectorAsImageHeight = 0;
             if (modelVectorAsImageWidth < 0)
                 modelVectorAsImageWidth = 0;
+
+            if (AllocationCounter::isEnabled())
+            {
+                ImGui::Separator();
+                ImGui::Text("Debug");
+                ImGui::Text("Heap allocations last frame: %zu", m_lastFrameHeapAllocations);
+                ImGui::Text("ImGui allocations last frame: %zu", m_lastFrameImGuiAllocations);
+                ImGui::Text("Frame arena: %zu bytes", m_frameArena.capacity());
+            }
         }
         ImGui::End();
     }
 
+    void Handler::StopTraining()
+    {
+        m_trainer.stop();
+        if (m_somTrainingThread.joinable())
+            m_somTrainingThread.join();
+        if (m_workspaceThread.joinable())
+            m_workspaceThread.join();
+    }
+
     void Handler::SetDataset(std::unique_ptr<DataSet> dataset)
     {
+        if (isTraining())
+        {
+            std::cerr << "Can not change the dataset while training" << std::endl;
+            return;
+        }
+
         m_dataset = std::unique_ptr<DataSet>{std::move(dataset)};
+        m_dataMatrix.reset();
+        m_previewData.reset();
         m_som = Som(10, 10, m_dataset->vectorLength());
+        ResetHistory();
+        ++m_datasetGeneration;
+        ++m_modelGeneration;
+    }
+
+    Workspace Handler::captureWorkspace() const
+    {
+        auto workspace = Workspace{};
+        workspace.datasetPath = trainingSetPath;
+        workspace.somWidth = m_somWidth;
+        workspace.somHeight = m_somHeight;
+        workspace.initSigma = m_initSigma;
+        workspace.seed = m_seed;
+        workspace.training = m_trainingParameters;
+        workspace.redColumnId = m_currentRedColumnId;
+        workspace.greenColumnId = m_currentGreenColumnId;
+        workspace.blueColumnId = m_currentBlueColumnId;
+        workspace.uMatrixRange = m_uMatrixRange;
+        workspace.weightMapRange = m_weightMapRange;
+        workspace.bmuHitsRange = m_bmuHitsRange;
+        workspace.showModelVectorsAsImage = showModelVectorsAsImage;
+        workspace.modelVectorAsImageWidth = modelVectorAsImageWidth;
+        workspace.modelVectorAsImageHeight = modelVectorAsImageHeight;
+        workspace.hexagonalTopology = m_hexagonalTopology;
+        workspace.colormap = m_colormap.getName();
+        workspace.colormapEntries = m_colormap.getEntries();
+        workspace.bmuHitsLogScale = m_bmuHitsLogScale;
+        workspace.cacheBudgetMegabytes = m_memoryBudget.getBudget() / (1024 * 1024);
+        workspace.historyEnabled = m_history.isEnabled();
+        workspace.historyInterval = m_history.getInterval();
+        workspace.historyMemoryCapMegabytes = m_history.getMemoryCap() / (1024 * 1024);
+        workspace.labelMapColumn = m_labelColumn;
+
+        return workspace;
+    }
+
+    void Handler::applyWorkspace(const Workspace &workspace)
+    {
+        trainingSetPath = workspace.datasetPath;
+        m_somWidth = workspace.somWidth;
+        m_somHeight = workspace.somHeight;
+        m_initSigma = workspace.initSigma;
+        m_seed = workspace.seed;
+        m_trainingParameters = workspace.training;
+        m_currentRedColumnId = workspace.redColumnId;
+        m_currentGreenColumnId = workspace.greenColumnId;
+        m_currentBlueColumnId = workspace.blueColumnId;
+        m_uMatrixRange = workspace.uMatrixRange;
+        m_weightMapRange = workspace.weightMapRange;
+        m_bmuHitsRange = workspace.bmuHitsRange;
+        showModelVectorsAsImage = workspace.showModelVectorsAsImage;
+        modelVectorAsImageWidth = workspace.modelVectorAsImageWidth;
+        modelVectorAsImageHeight = workspace.modelVectorAsImageHeight;
+        m_hexagonalTopology = workspace.hexagonalTopology;
+        m_colormap = Colormap(workspace.colormap, workspace.colormapEntries);
+        m_bmuHitsLogScale = workspace.bmuHitsLogScale;
+        m_memoryBudget.setBudget(workspace.cacheBudgetMegabytes * 1024 * 1024);
+        m_history.setEnabled(workspace.historyEnabled);
+        m_history.setInterval(workspace.historyInterval);
+        m_history.setMemoryCap(workspace.historyMemoryCapMegabytes * 1024 * 1024);
+        m_labelColumn = workspace.labelMapColumn;
+    }
+
+    bool Handler::OpenWorkspace(const std::string &path)
+    {
+        if (isWorkspaceLoading() || isTraining())
+            return false;
+
+        auto workspace = Workspace::load(path);
+        if (!workspace)
+            return false;
+
+        /* Lightweight UI state applies at once, the rest is loaded once the first frame is up */
+        applyWorkspace(*workspace);
+        m_pendingWorkspace = std::move(workspace);
+
+        return true;
+    }
+
+    bool Handler::SaveWorkspace(const std::string &path) const
+    {
+        if (isTraining())
+        {
+            std::cerr << "Can not save the workspace while training" << std::endl;
+            return false;
+        }
+
+        auto workspace = captureWorkspace();
+        workspace.modelPath = Workspace::modelPathFor(path);
+
+        return Codebook::fromSom(m_som).save(workspace.modelPath) && workspace.save(path);
+    }
+
+    bool Handler::isWorkspaceLoading() const
+    {
+        return m_pendingWorkspace.has_value() || m_modelFuture.valid() || m_datasetFuture.valid() || m_derivedFuture.valid();
+    }
+
+    void Handler::StartWorkspaceLoading()
+    {
+        auto workspace = std::move(*m_pendingWorkspace);
+        m_pendingWorkspace.reset();
+
+        auto modelPromise = std::promise<std::optional<Codebook>>{};
+        auto datasetPromise = std::promise<LoadedDataset>{};
+        auto derivedPromise = std::promise<DerivedViews>{};
+        m_modelFuture = modelPromise.get_future();
+        m_datasetFuture = datasetPromise.get_future();
+        m_derivedFuture = derivedPromise.get_future();
+
+        /* Whatever most of the visible windows are waiting for is loaded first */
+        const bool modelFirst = m_visibleModelWindows >= m_visibleDatasetWindows;
+
+        if (m_workspaceThread.joinable())
+            m_workspaceThread.join();
+
+        m_workspaceThread = std::thread([workspace = std::move(workspace), modelFirst,
+                                         modelPromise = std::move(modelPromise),
+                                         datasetPromise = std::move(datasetPromise),
+                                         derivedPromise = std::move(derivedPromise)]() mutable
+                                        {
+            auto loadModel = [&]()
+            {
+                try
+                {
+                    modelPromise.set_value(workspace.modelPath.empty() ? std::optional<Codebook>{} : Codebook::load(workspace.modelPath));
+                }
+                catch (...)
+                {
+                    modelPromise.set_exception(std::current_exception());
+                }
+            };
+
+            /* The derived views are built before the dataset is handed over, after that only the main thread touches it */
+            auto loadDataset = [&]()
+            {
+                auto loaded = LoadedDataset{};
+                try
+                {
+                    if (!workspace.datasetPath.empty())
+                    {
+                        loaded.loader = openDataLoader(workspace.datasetPath, "../data/columnSpec.txt");
+                        if (loaded.loader != nullptr)
+                            loaded.dataset = std::unique_ptr<DataSet>(new DataSet(*loaded.loader));
+                    }
+                }
+                catch (...)
+                {
+                    datasetPromise.set_exception(std::current_exception());
+                    derivedPromise.set_value(DerivedViews{});
+                    return;
+                }
+
+                try
+                {
+                    auto derived = DerivedViews{};
+                    if (loaded.dataset != nullptr)
+                    {
+                        derived.previewData = loaded.dataset->getPreviewData(100);
+                        if (needsInAppTrainer(workspace.training))
+                            derived.dataMatrix = denseMatrix(loaded.loader.get(), *loaded.dataset);
+                    }
+                    derivedPromise.set_value(std::move(derived));
+                }
+                catch (...)
+                {
+                    derivedPromise.set_exception(std::current_exception());
+                }
+                datasetPromise.set_value(std::move(loaded));
+            };
+
+            if (modelFirst)
+            {
+                loadModel();
+                loadDataset();
+            }
+            else
+            {
+                loadDataset();
+                loadModel();
+            } });
+    }
+
+    void Handler::PollWorkspaceLoading()
+    {
+        auto isReady = [](const auto &future)
+        {
+            return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        };
+
+        if (isReady(m_modelFuture))
+        {
+            auto codebook = m_modelFuture.get();
+            if (codebook && !codebook->empty())
+            {
+                m_som = Som(codebook->getWidth(), codebook->getHeight(), codebook->getDepth());
+                ResetHistory();
+                codebook->applyTo(m_som);
+                ++m_modelGeneration;
+            }
+        }
+
+        if (isReady(m_datasetFuture))
+        {
+            auto loaded = m_datasetFuture.get();
+            if (loaded.dataset != nullptr)
+            {
+                m_dataLoader = std::move(loaded.loader);
+                m_dataset = std::move(loaded.dataset);
+                ++m_datasetGeneration;
+                m_dataMatrix.reset();
+                m_previewData.reset();
+            }
+        }
+
+        /* Keep a restored model only if it fits the dataset */
+        if (m_dataset != nullptr && !m_modelFuture.valid() && getSomDepth() != m_dataset->vectorLength())
+        {
+            m_som = Som(m_somWidth, m_somHeight, m_dataset->vectorLength());
+            ResetHistory();
+            ++m_modelGeneration;
+        }
+
+        if (!m_datasetFuture.valid() && isReady(m_derivedFuture))
+        {
+            auto derived = m_derivedFuture.get();
+            if (m_dataset != nullptr)
+            {
+                m_previewData = std::move(derived.previewData);
+                m_datasetViews.hasPreviewText = false;
+                m_dataMatrix = std::move(derived.dataMatrix);
+            }
+        }
+    }
+
+    void Handler::RefreshViews()
+    {
+        /* The Som changes under our feet while training, otherwise only through the generation bumps */
+        const auto currentlyTraining = isTraining();
+        if (m_wasTraining && !currentlyTraining)
+            ++m_modelGeneration;
+        m_wasTraining = currentlyTraining;
+
+        /* libsom has no epoch hook, its snapshots are taken when the frame sees a new epoch,
+           and once more on the first frame after it stops so the final map is always kept */
+        const auto somTraining = m_som.isTraining();
+        if (somTraining || m_somWasTraining)
+        {
+            size_t epochs;
+            {
+                const std::lock_guard<std::mutex> lock(m_som.metricsMutex);
+                const auto recorded = m_som.getMetrics().MeanSquaredError.size();
+                epochs = recorded >= m_historyEpochBase ? recorded - m_historyEpochBase : recorded;
+            }
+            if (epochs != m_lastRecordedEpoch)
+            {
+                m_lastRecordedEpoch = epochs;
+                m_history.record(epochs, Codebook::fromSom(m_som), !somTraining);
+            }
+        }
+        m_somWasTraining = somTraining;
+
+        if (m_historyEpoch)
+            PollHistory();
+        else if (currentlyTraining)
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if (now - m_lastTrainingRefresh >= trainingRefreshInterval)
+            {
+                m_lastTrainingRefresh = now;
+                if (m_trainer.isTraining())
+                {
+                    if (m_trainer.takeSnapshot(m_trainingSnapshot, m_trainingSnapshotVersion))
+                        m_modelViews.showTraining(m_trainingSnapshot, MapRaster::computeUMatrix(m_trainingSnapshot));
+                }
+                else
+                    /* libsom publishes nothing, its model is read while it trains */
+                    m_modelViews.refresh(m_som, m_modelGeneration);
+            }
+        }
+        else if (m_modelViews.generation != m_modelGeneration)
+            m_modelViews.refresh(m_som, m_modelGeneration);
+
+        if (m_dataset != nullptr && m_datasetViews.generation != m_datasetGeneration)
+            m_datasetViews.refresh(*m_dataset, m_datasetGeneration);
     }
 
     void Handler::RenderExplorer()
     {
         ImGui::DockSpaceOverViewport(ImGui::GetMainViewport());
 
+        const auto heapAllocationsBefore = AllocationCounter::heapAllocations();
+        const auto imGuiAllocationsBefore = AllocationCounter::imGuiAllocations();
+
+        m_visibleModelWindows = 0;
+        m_visibleDatasetWindows = 0;
+        m_frameArena.reset();
+
         try
         {
+            PollWorkspaceLoading();
+            RefreshViews();
+
             LoadMainMenu();
 
             SomHandler();
@@ -674,15 +1622,22 @@ namespace VSOMExplorer
 
             DatasetViewer();
             DatasetEditor();
+            QueryViewer();
 
             RenderUMatrix();
             RenderWeigthMap();
             RenderBmuHits();
+            LabelViewer();
 
             MetricsViewer();
+            MemoryViewer();
+            HistoryViewer();
 
             RenderMap();
             RenderSigmaMap();
+
+            if (m_pendingWorkspace)
+                StartWorkspaceLoading();
         }
         catch (const std::exception &e)
         {
@@ -692,5 +1647,10 @@ namespace VSOMExplorer
         {
             ;
         }
+
+        m_memoryBudget.enforce();
+
+        m_lastFrameHeapAllocations = AllocationCounter::heapAllocations() - heapAllocationsBefore;
+        m_lastFrameImGuiAllocations = AllocationCounter::imGuiAllocations() - imGuiAllocationsBefore;
     }
 }
\ No newline at end of file
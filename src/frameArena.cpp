@@ -0,0 +1,48 @@
+#include "frameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace VSOMExplorer
+{
+    void *FrameArena::allocateBytes(size_t bytes, size_t alignment)
+    {
+        while (m_currentBlock < m_blocks.size())
+        {
+            auto &block = m_blocks[m_currentBlock];
+            const auto base = reinterpret_cast<uintptr_t>(block.data.get());
+            const auto aligned = (base + m_offset + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+
+            if (aligned + bytes <= base + block.capacity)
+            {
+                m_offset = aligned + bytes - base;
+                return reinterpret_cast<void *>(aligned);
+            }
+
+            ++m_currentBlock;
+            m_offset = 0;
+        }
+
+        const auto capacity = std::max(defaultBlockSize, bytes + alignment);
+        m_blocks.push_back(Block{std::make_unique<std::byte[]>(capacity), capacity});
+        m_currentBlock = m_blocks.size() - 1;
+        m_offset = 0;
+
+        return allocateBytes(bytes, alignment);
+    }
+
+    void FrameArena::reset()
+    {
+        m_currentBlock = 0;
+        m_offset = 0;
+    }
+
+    size_t FrameArena::capacity() const
+    {
+        size_t total{0};
+        for (const auto &block : m_blocks)
+            total += block.capacity;
+
+        return total;
+    }
+}
@@ -0,0 +1,172 @@
+#include "hexGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace VSOMExplorer
+{
+    namespace
+    {
+        constexpr float sqrt3 = 1.7320508f;
+
+        /* Fan of four triangles over the six corners */
+        constexpr ImDrawIdx cellIndices[12] = {0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 5};
+    }
+
+    bool HexGeometry::update(size_t columns, size_t rows, const ImVec2 &viewport)
+    {
+        if (columns == m_columns && rows == m_rows && viewport.x == m_viewport.x && viewport.y == m_viewport.y)
+            return false;
+
+        m_columns = columns;
+        m_rows = rows;
+        m_viewport = viewport;
+        rebuild();
+
+        return true;
+    }
+
+    void HexGeometry::rebuild()
+    {
+        const auto cells = m_columns * m_rows;
+        m_vertices.resize(cells * verticesPerCell);
+        m_colors.assign(cells, IM_COL32(0, 0, 0, 255));
+
+        if (cells == 0)
+            return;
+
+        /* Largest radius for which the lattice fits the viewport */
+        const auto radiusFromWidth = m_viewport.x / (sqrt3 * (static_cast<float>(m_columns) + (m_rows > 1 ? 0.5f : 0.f)));
+        const auto radiusFromHeight = m_viewport.y / (1.5f * static_cast<float>(m_rows) + 0.5f);
+        m_radius = std::max(std::min(radiusFromWidth, radiusFromHeight), 0.f);
+
+        const auto uv = ImGui::GetFontTexUvWhitePixel();
+        float cornerX[6], cornerY[6];
+        for (size_t corner{0}; corner < 6; ++corner)
+        {
+            const auto angle = 3.14159265f / 180.f * (60.f * static_cast<float>(corner) - 30.f);
+            cornerX[corner] = m_radius * std::cos(angle);
+            cornerY[corner] = m_radius * std::sin(angle);
+        }
+
+        for (size_t row{0}; row < m_rows; ++row)
+        {
+            for (size_t column{0}; column < m_columns; ++column)
+            {
+                const auto centerX = sqrt3 * m_radius * (static_cast<float>(column) + 0.5f * static_cast<float>(row & 1) + 0.5f);
+                const auto centerY = m_radius * (1.5f * static_cast<float>(row) + 1.f);
+
+                auto *vertex = m_vertices.data() + (row * m_columns + column) * verticesPerCell;
+                for (size_t corner{0}; corner < 6; ++corner)
+                {
+                    vertex[corner].pos = ImVec2(centerX + cornerX[corner], centerY + cornerY[corner]);
+                    vertex[corner].uv = uv;
+                    vertex[corner].col = m_colors[row * m_columns + column];
+                }
+            }
+        }
+    }
+
+    void HexGeometry::setColors(const ImU32 *colors)
+    {
+        if (m_colors.empty() || std::memcmp(colors, m_colors.data(), m_colors.size() * sizeof(ImU32)) == 0)
+            return;
+
+        std::memcpy(m_colors.data(), colors, m_colors.size() * sizeof(ImU32));
+        for (size_t cell{0}; cell < m_colors.size(); ++cell)
+        {
+            auto *vertex = m_vertices.data() + cell * verticesPerCell;
+            for (size_t corner{0}; corner < verticesPerCell; ++corner)
+                vertex[corner].col = colors[cell];
+        }
+    }
+
+    void HexGeometry::outline(ImDrawList *drawList, const ImVec2 &origin, size_t column, size_t row, ImU32 color, float thickness) const
+    {
+        if (column >= m_columns || row >= m_rows || m_vertices.empty())
+            return;
+
+        ImVec2 corners[verticesPerCell];
+        const auto *vertex = m_vertices.data() + (row * m_columns + column) * verticesPerCell;
+        for (size_t corner{0}; corner < verticesPerCell; ++corner)
+            corners[corner] = ImVec2(origin.x + vertex[corner].pos.x, origin.y + vertex[corner].pos.y);
+
+        drawList->AddPolyline(corners, static_cast<int>(verticesPerCell), color, ImDrawFlags_Closed, thickness);
+    }
+
+    void HexGeometry::draw(ImDrawList *drawList, const ImVec2 &origin) const
+    {
+        const auto cells = m_colors.size();
+
+        for (size_t first{0}; first < cells; first += cellsPerBatch)
+        {
+            const auto count = std::min(cellsPerBatch, cells - first);
+            drawList->PrimReserve(static_cast<int>(count * indicesPerCell), static_cast<int>(count * verticesPerCell));
+
+            const auto *source = m_vertices.data() + first * verticesPerCell;
+            for (size_t i{0}; i < count * verticesPerCell; ++i)
+            {
+                drawList->_VtxWritePtr[i] = source[i];
+                drawList->_VtxWritePtr[i].pos.x += origin.x;
+                drawList->_VtxWritePtr[i].pos.y += origin.y;
+            }
+
+            const auto base = drawList->_VtxCurrentIdx;
+            for (size_t cell{0}; cell < count; ++cell)
+                for (size_t i{0}; i < indicesPerCell; ++i)
+                    drawList->_IdxWritePtr[cell * indicesPerCell + i] = static_cast<ImDrawIdx>(base + cell * verticesPerCell + cellIndices[i]);
+
+            drawList->_VtxWritePtr += count * verticesPerCell;
+            drawList->_IdxWritePtr += count * indicesPerCell;
+            drawList->_VtxCurrentIdx += static_cast<unsigned int>(count * verticesPerCell);
+        }
+    }
+
+    bool HexGeometry::hitTest(const ImVec2 &position, size_t *column, size_t *row) const
+    {
+        if (m_radius <= 0.f)
+            return false;
+
+        /* Relative to the center of cell (0, 0) */
+        const auto x = position.x - sqrt3 * 0.5f * m_radius;
+        const auto y = position.y - m_radius;
+
+        /* Fractional axial coordinates, rounded in cube space */
+        const auto q = (sqrt3 / 3.f * x - y / 3.f) / m_radius;
+        const auto r = (2.f / 3.f * y) / m_radius;
+        const auto s = -q - r;
+
+        auto roundedQ = std::round(q);
+        auto roundedR = std::round(r);
+        const auto roundedS = std::round(s);
+
+        const auto qDiff = std::abs(roundedQ - q);
+        const auto rDiff = std::abs(roundedR - r);
+        const auto sDiff = std::abs(roundedS - s);
+
+        if (qDiff > rDiff && qDiff > sDiff)
+            roundedQ = -roundedR - roundedS;
+        else if (rDiff > sDiff)
+            roundedR = -roundedQ - roundedS;
+
+        /* Axial to odd-r offset */
+        const auto axialRow = static_cast<long>(roundedR);
+        const auto offsetColumn = static_cast<long>(roundedQ) + (axialRow - (axialRow & 1)) / 2;
+
+        if (axialRow < 0 || offsetColumn < 0 || static_cast<size_t>(axialRow) >= m_rows || static_cast<size_t>(offsetColumn) >= m_columns)
+            return false;
+
+        *column = static_cast<size_t>(offsetColumn);
+        *row = static_cast<size_t>(axialRow);
+        return true;
+    }
+
+    void HexGeometry::clear()
+    {
+        m_columns = 0;
+        m_rows = 0;
+        m_vertices = std::vector<ImDrawVert>{};
+        m_colors = std::vector<ImU32>{};
+    }
+}
@@ -0,0 +1,184 @@
+#include "labelMaps.h"
+#include "threadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+
+namespace VSOMExplorer
+{
+    namespace
+    {
+        /* Neuron in the high half, label bits in the low half */
+        using Counter = std::unordered_map<uint64_t, uint32_t>;
+
+        uint64_t countKey(size_t neuron, float label)
+        {
+            /* -0 and 0 are the same class */
+            label = label == 0.f ? 0.f : label;
+            uint32_t bits;
+            std::memcpy(&bits, &label, sizeof(bits));
+            return (static_cast<uint64_t>(neuron) << 32) | bits;
+        }
+
+        size_t keyNeuron(uint64_t key) { return static_cast<size_t>(key >> 32); }
+
+        float keyLabel(uint64_t key)
+        {
+            const auto bits = static_cast<uint32_t>(key);
+            float label;
+            std::memcpy(&label, &bits, sizeof(label));
+            return label;
+        }
+
+        void finishGrid(ValueGrid &grid)
+        {
+            const auto [min, max] = std::minmax_element(grid.values.begin(), grid.values.end());
+            grid.minValue = min != grid.values.end() ? *min : 0.f;
+            grid.maxValue = max != grid.values.end() ? *max : 0.f;
+        }
+    }
+
+    bool LabelMaps::matches(size_t currentRevision, size_t currentDatasetGeneration, size_t currentLabelColumn) const
+    {
+        return revision == currentRevision && datasetGeneration == currentDatasetGeneration && labelColumn == currentLabelColumn;
+    }
+
+    void LabelMaps::updateLabels()
+    {
+        classLabels.clear();
+        for (const auto &name : classNames)
+            classLabels.push_back(name.c_str());
+    }
+
+    size_t LabelMaps::memoryBytes() const
+    {
+        auto bytes = purity.memoryBytes() + entropy.memoryBytes() + majority.capacity() * sizeof(size_t);
+        for (const auto &grid : classHits)
+            bytes += grid.memoryBytes();
+        return bytes;
+    }
+
+    LabelMaps computeLabelMaps(const Codebook &codebook, const DataMatrix &data, const std::vector<float> &weights, BmuSearchMode mode, size_t labelColumn, size_t threads)
+    {
+        auto maps = LabelMaps{};
+        maps.labelColumn = labelColumn;
+        maps.weights = weights;
+
+        const auto neurons = codebook.size();
+        if (neurons == 0 || labelColumn >= data.vectorLength() || data.vectorLength() != codebook.getDepth())
+            return maps;
+
+        /* A continuous column would give one class per row, there is nothing useful to draw then.
+           The classes come first from the label column alone, which stops at the first one past the limit
+           before any BMU is searched. */
+        for (size_t row{0}; row < data.size(); ++row)
+        {
+            const auto label = data.getRow(row)[labelColumn];
+            if (std::isnan(label))
+                continue;
+
+            const auto found = std::lower_bound(maps.classes.begin(), maps.classes.end(), label);
+            if (found != maps.classes.end() && *found == label)
+                continue;
+            if (maps.classes.size() == LabelMaps::maxClasses)
+            {
+                maps.classes.clear();
+                maps.tooManyClasses = true;
+                return maps;
+            }
+            maps.classes.insert(found, label);
+        }
+
+        auto pool = ThreadPool(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency()));
+        auto search = BmuSearch(codebook, weights, mode);
+
+        /* One contiguous share of the rows per worker, each with its own counter so nothing is shared while counting */
+        const auto tasks = pool.size();
+        const auto rowsPerTask = (data.size() + tasks - 1) / tasks;
+        auto counters = std::vector<Counter>(tasks);
+        auto unlabelled = std::vector<size_t>(tasks, 0);
+        pool.parallelFor(tasks, [&](size_t task)
+                         {
+            auto &counter = counters[task];
+            for (size_t row{task * rowsPerTask}; row < std::min(data.size(), (task + 1) * rowsPerTask); ++row)
+            {
+                const auto *sample = data.getRow(row);
+                const auto label = sample[labelColumn];
+                if (std::isnan(label))
+                {
+                    ++unlabelled[task];
+                    continue;
+                }
+                ++counter[countKey(search.find(sample), label)];
+            } });
+
+        auto merged = std::move(counters[0]);
+        for (size_t task{1}; task < tasks; ++task)
+        {
+            for (const auto &[key, count] : counters[task])
+                merged[key] += count;
+        }
+        maps.unlabelledRows = std::accumulate(unlabelled.begin(), unlabelled.end(), size_t{0});
+
+        for (const auto label : maps.classes)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "%g", label);
+            maps.classNames.emplace_back(name);
+        }
+        maps.updateLabels();
+
+        const auto emptyGrid = ValueGrid{codebook.getWidth(), codebook.getHeight(), 0.f, 0.f, std::vector<float>(neurons, 0.f)};
+        maps.classHits.assign(maps.classes.size(), emptyGrid);
+        for (const auto &[key, count] : merged)
+        {
+            const auto label = static_cast<size_t>(std::lower_bound(maps.classes.begin(), maps.classes.end(), keyLabel(key)) - maps.classes.begin());
+            maps.classHits[label].values[keyNeuron(key)] = static_cast<float>(count);
+        }
+
+        maps.majority.assign(neurons, LabelMaps::noClass);
+        maps.purity = emptyGrid;
+        maps.entropy = emptyGrid;
+        for (size_t neuron{0}; neuron < neurons; ++neuron)
+        {
+            float total{0.f};
+            float best{0.f};
+            for (size_t label{0}; label < maps.classes.size(); ++label)
+            {
+                const auto hits = maps.classHits[label].values[neuron];
+                total += hits;
+                /* Ties go to the lowest label */
+                if (hits > best)
+                {
+                    best = hits;
+                    maps.majority[neuron] = label;
+                }
+            }
+            if (total == 0.f)
+                continue;
+
+            float entropy{0.f};
+            for (const auto &grid : maps.classHits)
+            {
+                const auto share = grid.values[neuron] / total;
+                if (share > 0.f)
+                    entropy -= share * std::log2(share);
+            }
+            maps.purity.values[neuron] = best / total;
+            maps.entropy.values[neuron] = entropy;
+        }
+
+        for (auto &grid : maps.classHits)
+            finishGrid(grid);
+        finishGrid(maps.purity);
+        finishGrid(maps.entropy);
+
+        return maps;
+    }
+}
@@ -0,0 +1,186 @@
+#include "mapRaster.h"
+#include "threadPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace VSOMExplorer::MapRaster
+{
+    namespace
+    {
+        void setPixel(uint8_t *pixel, uint32_t color)
+        {
+            pixel[0] = static_cast<uint8_t>(color);
+            pixel[1] = static_cast<uint8_t>(color >> 8);
+            pixel[2] = static_cast<uint8_t>(color >> 16);
+            pixel[3] = static_cast<uint8_t>(color >> 24);
+        }
+
+        void finishGrid(ValueGrid &grid)
+        {
+            const auto [minimum, maximum] = std::minmax_element(grid.values.begin(), grid.values.end());
+            grid.minValue = grid.values.empty() ? 0.f : *minimum;
+            grid.maxValue = grid.values.empty() ? 0.f : *maximum;
+        }
+
+        /* Same mapping as the map windows, colored once per cell and then stretched */
+        Image rasterizeGrid(const ValueGrid &grid, float min, const View &view, size_t width, size_t height)
+        {
+            auto image = Image{width, height, std::vector<uint8_t>(width * height * 4)};
+            if (grid.width == 0 || grid.height == 0)
+                return image;
+
+            auto colors = std::vector<uint32_t>(grid.values.size());
+            Colormap(view.colormap, view.colormapEntries).apply(grid.values.data(), grid.values.size(), min, grid.maxValue, view.range, view.logScale, colors.data());
+
+            for (size_t y{0}; y < height; ++y)
+            {
+                const auto cellY = y * grid.height / height;
+                for (size_t x{0}; x < width; ++x)
+                {
+                    const auto cellX = x * grid.width / width;
+                    setPixel(image.pixel(x, y), colors[cellY * grid.width + cellX]);
+                }
+            }
+
+            return image;
+        }
+
+        Image rasterizeRgb(const Codebook &codebook, const View &view, size_t width, size_t height)
+        {
+            auto image = Image{width, height, std::vector<uint8_t>(width * height * 4)};
+            const auto depth = codebook.getDepth();
+            if (codebook.empty() || view.redColumnId >= depth || view.greenColumnId >= depth || view.blueColumnId >= depth)
+                return image;
+
+            const size_t channels[3] = {view.redColumnId, view.greenColumnId, view.blueColumnId};
+            std::vector<uint8_t> planes[3];
+            for (size_t channel{0}; channel < 3; ++channel)
+            {
+                const auto plane = componentPlane(codebook, channels[channel]);
+                planes[channel].resize(plane.values.size());
+                scaleToBytes(plane.values.data(), plane.values.size(), plane.minValue, plane.maxValue, planes[channel].data());
+            }
+
+            for (size_t y{0}; y < height; ++y)
+            {
+                const auto cellY = y * codebook.getHeight() / height;
+                for (size_t x{0}; x < width; ++x)
+                {
+                    const auto cell = codebook.getIndex(x * codebook.getWidth() / width, cellY);
+                    auto *pixel = image.pixel(x, y);
+                    for (size_t channel{0}; channel < 3; ++channel)
+                        pixel[channel] = planes[channel][cell];
+                    pixel[3] = 255;
+                }
+            }
+
+            return image;
+        }
+    }
+
+    ValueGrid computeUMatrix(const Codebook &codebook)
+    {
+        const auto width = codebook.getWidth();
+        const auto height = codebook.getHeight();
+        const auto depth = codebook.getDepth();
+
+        auto grid = ValueGrid{width, height, 0.f, 0.f, std::vector<float>(width * height, 0.f)};
+
+        auto distance = [&codebook, depth](size_t a, size_t b)
+        {
+            const auto *first = codebook.getNeuron(a);
+            const auto *second = codebook.getNeuron(b);
+            float sum{0.f};
+            for (size_t i{0}; i < depth; ++i)
+                sum += (first[i] - second[i]) * (first[i] - second[i]);
+            return std::sqrt(sum);
+        };
+
+        for (size_t y{0}; y < height; ++y)
+        {
+            for (size_t x{0}; x < width; ++x)
+            {
+                const auto index = codebook.getIndex(x, y);
+                float sum{0.f};
+                size_t neighbours{0};
+
+                auto addNeighbour = [&](size_t neighbourX, size_t neighbourY)
+                {
+                    sum += distance(index, codebook.getIndex(neighbourX, neighbourY));
+                    ++neighbours;
+                };
+
+                if (x > 0)
+                    addNeighbour(x - 1, y);
+                if (x + 1 < width)
+                    addNeighbour(x + 1, y);
+                if (y > 0)
+                    addNeighbour(x, y - 1);
+                if (y + 1 < height)
+                    addNeighbour(x, y + 1);
+
+                grid.values[index] = neighbours > 0 ? sum / static_cast<float>(neighbours) : 0.f;
+            }
+        }
+
+        finishGrid(grid);
+        return grid;
+    }
+
+    ValueGrid computeBmuHits(const Codebook &codebook, const DataMatrix &data, const std::vector<float> &weights, BmuSearchMode mode)
+    {
+        auto grid = ValueGrid{codebook.getWidth(), codebook.getHeight(), 0.f, 0.f, std::vector<float>(codebook.size(), 0.f)};
+        auto search = BmuSearch(codebook, weights, mode);
+
+        for (size_t row{0}; row < data.size(); ++row)
+            grid.values[search.find(data.getRow(row))] += 1.f;
+
+        finishGrid(grid);
+        return grid;
+    }
+
+    ValueGrid componentPlane(const Codebook &codebook, size_t feature)
+    {
+        auto grid = ValueGrid{codebook.getWidth(), codebook.getHeight(), 0.f, 0.f, std::vector<float>(codebook.size(), 0.f)};
+        for (size_t index{0}; index < codebook.size(); ++index)
+            grid.values[index] = codebook.getNeuron(index)[feature];
+
+        finishGrid(grid);
+        return grid;
+    }
+
+    Image rasterize(const Codebook &codebook, const ValueGrid *hits, const View &view, size_t width, size_t height)
+    {
+        switch (view.layer)
+        {
+        case Layer::UMatrix:
+            return rasterizeGrid(computeUMatrix(codebook), 0.f, view, width, height);
+        case Layer::BmuHits:
+            return hits != nullptr ? rasterizeGrid(*hits, 0.f, view, width, height) : Image{width, height, std::vector<uint8_t>(width * height * 4)};
+        case Layer::ComponentPlane:
+        {
+            if (view.feature >= codebook.getDepth())
+                return Image{width, height, std::vector<uint8_t>(width * height * 4)};
+            const auto plane = componentPlane(codebook, view.feature);
+            return rasterizeGrid(plane, plane.minValue, view, width, height);
+        }
+        case Layer::FeatureRgb:
+        default:
+            return rasterizeRgb(codebook, view, width, height);
+        }
+    }
+
+    std::vector<Image> rasterizeAll(const Codebook &codebook, const ValueGrid *hits, const std::vector<View> &views, size_t width, size_t height, size_t threads)
+    {
+        const auto workers = threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        auto pool = ThreadPool(std::min(workers, views.size()));
+
+        auto images = std::vector<Image>(views.size());
+        pool.parallelFor(views.size(), [&](size_t index)
+                         { images[index] = rasterize(codebook, hits, views[index], width, height); });
+
+        return images;
+    }
+}
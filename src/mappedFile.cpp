@@ -0,0 +1,113 @@
+#include "mappedFile.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VSOMExplorer
+{
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string &path)
+    {
+        m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE)
+        {
+            m_file = nullptr;
+            return;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+        {
+            close();
+            return;
+        }
+
+        m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping == nullptr)
+        {
+            close();
+            return;
+        }
+
+        m_data = static_cast<const char *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        m_size = m_data != nullptr ? static_cast<size_t>(size.QuadPart) : 0;
+        if (m_data == nullptr)
+            close();
+    }
+
+    void MappedFile::close()
+    {
+        if (m_data != nullptr)
+            UnmapViewOfFile(m_data);
+        if (m_mapping != nullptr)
+            CloseHandle(m_mapping);
+        if (m_file != nullptr)
+            CloseHandle(m_file);
+
+        m_data = nullptr;
+        m_size = 0;
+        m_mapping = nullptr;
+        m_file = nullptr;
+    }
+#else
+    MappedFile::MappedFile(const std::string &path)
+    {
+        const auto descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0)
+            return;
+
+        struct stat status;
+        if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+        {
+            auto *mapping = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (mapping != MAP_FAILED)
+            {
+                /* Parsing walks the file front to back, let the kernel read ahead aggressively */
+                madvise(mapping, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+                m_data = static_cast<const char *>(mapping);
+                m_size = static_cast<size_t>(status.st_size);
+            }
+        }
+
+        /* The mapping stays valid after the descriptor is closed */
+        ::close(descriptor);
+    }
+
+    void MappedFile::close()
+    {
+        if (m_data != nullptr)
+            munmap(const_cast<char *>(m_data), m_size);
+
+        m_data = nullptr;
+        m_size = 0;
+    }
+#endif
+
+    MappedFile::MappedFile(MappedFile &&other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+            m_file = std::exchange(other.m_file, nullptr);
+            m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+        }
+        return *this;
+    }
+}
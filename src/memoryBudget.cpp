@@ -0,0 +1,48 @@
+#include "memoryBudget.h"
+
+namespace VSOMExplorer
+{
+    size_t MemoryBudget::add(std::string name, std::function<size_t()> bytes, std::function<bool()> evict)
+    {
+        m_caches.push_back(Cache{std::move(name), std::move(bytes), std::move(evict)});
+        return m_caches.size() - 1;
+    }
+
+    size_t MemoryBudget::totalBytes() const
+    {
+        size_t total{0};
+        for (const auto &cache : m_caches)
+            total += cache.bytes();
+        return total;
+    }
+
+    void MemoryBudget::enforce()
+    {
+        auto total = m_budget != unlimited ? totalBytes() : 0;
+
+        while (total > m_budget)
+        {
+            /* Few caches, a linear scan per eviction keeps this allocation free */
+            Cache *oldest = nullptr;
+            for (auto &cache : m_caches)
+            {
+                if (cache.lastUse >= m_frame || cache.lastEvictionAttempt == m_frame || cache.bytes() == 0)
+                    continue;
+                if (oldest == nullptr || cache.lastUse < oldest->lastUse)
+                    oldest = &cache;
+            }
+
+            if (oldest == nullptr)
+                break;
+
+            oldest->lastEvictionAttempt = m_frame;
+            if (oldest->evict())
+            {
+                ++oldest->evictions;
+                total = totalBytes();
+            }
+        }
+
+        ++m_frame;
+    }
+}
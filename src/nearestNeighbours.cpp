@@ -0,0 +1,60 @@
+#include "nearestNeighbours.h"
+#include "distance.h"
+
+#include <algorithm>
+
+namespace VSOMExplorer
+{
+    namespace
+    {
+        constexpr size_t vectorsPerTask = 16384;
+
+        bool closer(const Neighbour &a, const Neighbour &b)
+        {
+            return a.distance < b.distance || (a.distance == b.distance && a.index < b.index);
+        }
+    }
+
+    std::vector<Neighbour> nearestNeighbours(ThreadPool &pool, const float *query, const float *vectors, size_t count, size_t depth,
+                                             const std::vector<float> &weights, size_t k, size_t excludedIndex)
+    {
+        if (k == 0 || count == 0)
+            return {};
+
+        const auto tasks = (count + vectorsPerTask - 1) / vectorsPerTask;
+        auto best = std::vector<std::vector<Neighbour>>(tasks);
+        pool.parallelFor(tasks, [&](size_t task)
+                         {
+            /* Max-heap on distance, the front is the candidate to beat */
+            auto &heap = best[task];
+            heap.reserve(k);
+            for (size_t index{task * vectorsPerTask}; index < std::min(count, (task + 1) * vectorsPerTask); ++index)
+            {
+                if (index == excludedIndex)
+                    continue;
+
+                const auto candidate = Neighbour{index, weightedSquaredDistance(query, vectors + index * depth, weights.data(), depth)};
+                if (heap.size() < k)
+                {
+                    heap.push_back(candidate);
+                    std::push_heap(heap.begin(), heap.end(), closer);
+                }
+                else if (closer(candidate, heap.front()))
+                {
+                    std::pop_heap(heap.begin(), heap.end(), closer);
+                    heap.back() = candidate;
+                    std::push_heap(heap.begin(), heap.end(), closer);
+                }
+            } });
+
+        auto merged = std::vector<Neighbour>{};
+        merged.reserve(tasks * k);
+        for (const auto &heap : best)
+            merged.insert(merged.end(), heap.begin(), heap.end());
+
+        const auto kept = std::min(k, merged.size());
+        std::partial_sort(merged.begin(), merged.begin() + static_cast<std::ptrdiff_t>(kept), merged.end(), closer);
+        merged.resize(kept);
+        return merged;
+    }
+}
@@ -0,0 +1,238 @@
+#include "pngWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+
+namespace VSOMExplorer
+{
+    namespace
+    {
+        class BitWriter
+        {
+        private:
+            std::vector<uint8_t> &m_output;
+            uint32_t m_buffer{0};
+            int m_count{0};
+
+        public:
+            explicit BitWriter(std::vector<uint8_t> &output) : m_output{output} {}
+
+            /* Deflate packs values least significant bit first */
+            void write(uint32_t value, int bits)
+            {
+                m_buffer |= value << m_count;
+                m_count += bits;
+                while (m_count >= 8)
+                {
+                    m_output.push_back(static_cast<uint8_t>(m_buffer));
+                    m_buffer >>= 8;
+                    m_count -= 8;
+                }
+            }
+
+            /* Huffman codes are defined most significant bit first */
+            void writeCode(uint32_t code, int bits)
+            {
+                uint32_t reversed{0};
+                for (int i{0}; i < bits; ++i)
+                    reversed |= ((code >> i) & 1u) << (bits - 1 - i);
+                write(reversed, bits);
+            }
+
+            void flush()
+            {
+                if (m_count > 0)
+                    m_output.push_back(static_cast<uint8_t>(m_buffer));
+                m_buffer = 0;
+                m_count = 0;
+            }
+        };
+
+        constexpr std::array<uint16_t, 29> lengthBase = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        constexpr std::array<uint8_t, 29> lengthExtra = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        constexpr std::array<uint16_t, 30> distanceBase = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        constexpr std::array<uint8_t, 30> distanceExtra = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        void writeLiteralOrLength(BitWriter &writer, uint32_t symbol)
+        {
+            if (symbol < 144)
+                writer.writeCode(0x30 + symbol, 8);
+            else if (symbol < 256)
+                writer.writeCode(0x190 + symbol - 144, 9);
+            else if (symbol < 280)
+                writer.writeCode(symbol - 256, 7);
+            else
+                writer.writeCode(0xC0 + symbol - 280, 8);
+        }
+
+        void writeMatch(BitWriter &writer, size_t length, size_t distance)
+        {
+            size_t lengthCode{0};
+            while (lengthCode + 1 < lengthBase.size() && lengthBase[lengthCode + 1] <= length)
+                ++lengthCode;
+            writeLiteralOrLength(writer, static_cast<uint32_t>(257 + lengthCode));
+            writer.write(static_cast<uint32_t>(length - lengthBase[lengthCode]), lengthExtra[lengthCode]);
+
+            size_t distanceCode{0};
+            while (distanceCode + 1 < distanceBase.size() && distanceBase[distanceCode + 1] <= distance)
+                ++distanceCode;
+            writer.writeCode(static_cast<uint32_t>(distanceCode), 5);
+            writer.write(static_cast<uint32_t>(distance - distanceBase[distanceCode]), distanceExtra[distanceCode]);
+        }
+
+        /* Greedy LZ77 with a single entry hash table, good enough for blocky map images */
+        std::vector<uint8_t> deflate(const std::vector<uint8_t> &data)
+        {
+            constexpr size_t windowSize = 32768;
+            constexpr size_t maxMatch = 258;
+            constexpr size_t hashBits = 15;
+
+            auto output = std::vector<uint8_t>{};
+            auto writer = BitWriter(output);
+            writer.write(1, 1); // final block
+            writer.write(1, 2); // fixed Huffman codes
+
+            auto head = std::vector<size_t>(size_t{1} << hashBits, SIZE_MAX);
+            auto hash = [&data](size_t position)
+            {
+                const uint32_t value = data[position] | (data[position + 1] << 8) | (data[position + 2] << 16);
+                return (value * 2654435761u) >> (32 - hashBits);
+            };
+
+            size_t position{0};
+            while (position < data.size())
+            {
+                size_t bestLength{0}, bestDistance{0};
+
+                if (position + 3 <= data.size())
+                {
+                    const auto key = hash(position);
+                    const auto candidate = head[key];
+                    head[key] = position;
+
+                    if (candidate != SIZE_MAX && position - candidate <= windowSize)
+                    {
+                        size_t length{0};
+                        const auto limit = std::min(maxMatch, data.size() - position);
+                        while (length < limit && data[candidate + length] == data[position + length])
+                            ++length;
+                        if (length >= 3)
+                        {
+                            bestLength = length;
+                            bestDistance = position - candidate;
+                        }
+                    }
+                }
+
+                if (bestLength > 0)
+                {
+                    writeMatch(writer, bestLength, bestDistance);
+                    for (size_t i{1}; i < bestLength && position + i + 3 <= data.size(); ++i)
+                        head[hash(position + i)] = position + i;
+                    position += bestLength;
+                }
+                else
+                {
+                    writeLiteralOrLength(writer, data[position]);
+                    ++position;
+                }
+            }
+
+            writeLiteralOrLength(writer, 256);
+            writer.flush();
+
+            return output;
+        }
+
+        uint32_t crc32(const uint8_t *data, size_t length, uint32_t crc = 0)
+        {
+            static const auto table = []()
+            {
+                auto t = std::array<uint32_t, 256>{};
+                for (uint32_t n{0}; n < 256; ++n)
+                {
+                    auto c = n;
+                    for (int k{0}; k < 8; ++k)
+                        c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                    t[n] = c;
+                }
+                return t;
+            }();
+
+            crc = ~crc;
+            for (size_t i{0}; i < length; ++i)
+                crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+            return ~crc;
+        }
+
+        uint32_t adler32(const std::vector<uint8_t> &data)
+        {
+            uint32_t a{1}, b{0};
+            for (const auto byte : data)
+            {
+                a = (a + byte) % 65521;
+                b = (b + a) % 65521;
+            }
+            return (b << 16) | a;
+        }
+
+        void appendBigEndian(std::vector<uint8_t> &output, uint32_t value)
+        {
+            output.push_back(static_cast<uint8_t>(value >> 24));
+            output.push_back(static_cast<uint8_t>(value >> 16));
+            output.push_back(static_cast<uint8_t>(value >> 8));
+            output.push_back(static_cast<uint8_t>(value));
+        }
+
+        void appendChunk(std::vector<uint8_t> &output, const char *type, const std::vector<uint8_t> &data)
+        {
+            appendBigEndian(output, static_cast<uint32_t>(data.size()));
+            const auto typeStart = output.size();
+            output.insert(output.end(), type, type + 4);
+            output.insert(output.end(), data.begin(), data.end());
+            appendBigEndian(output, crc32(output.data() + typeStart, output.size() - typeStart));
+        }
+    }
+
+    std::vector<uint8_t> encodePng(const Image &image)
+    {
+        /* Filter type 0 on every scanline */
+        auto scanlines = std::vector<uint8_t>{};
+        scanlines.reserve(image.height * (image.width * 4 + 1));
+        for (size_t y{0}; y < image.height; ++y)
+        {
+            scanlines.push_back(0);
+            const auto *row = image.pixels.data() + y * image.width * 4;
+            scanlines.insert(scanlines.end(), row, row + image.width * 4);
+        }
+
+        auto zlib = std::vector<uint8_t>{0x78, 0x01};
+        const auto compressed = deflate(scanlines);
+        zlib.insert(zlib.end(), compressed.begin(), compressed.end());
+        appendBigEndian(zlib, adler32(scanlines));
+
+        auto header = std::vector<uint8_t>{};
+        appendBigEndian(header, static_cast<uint32_t>(image.width));
+        appendBigEndian(header, static_cast<uint32_t>(image.height));
+        header.insert(header.end(), {8, 6, 0, 0, 0}); // 8-bit RGBA, deflate, adaptive filtering, no interlace
+
+        auto png = std::vector<uint8_t>{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        appendChunk(png, "IHDR", header);
+        appendChunk(png, "IDAT", zlib);
+        appendChunk(png, "IEND", {});
+
+        return png;
+    }
+
+    bool writePng(const std::string &path, const Image &image)
+    {
+        const auto png = encodePng(image);
+
+        auto file = std::ofstream(path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(png.data()), static_cast<std::streamsize>(png.size()));
+
+        return static_cast<bool>(file);
+    }
+}
@@ -0,0 +1,144 @@
+#include "threadPool.h"
+
+#include <chrono>
+
+namespace VSOMExplorer
+{
+    ThreadPool::ThreadPool(size_t threads)
+    {
+        if (threads <= 1)
+            return;
+
+        for (size_t id{0}; id < threads; ++id)
+            m_queues.push_back(std::make_unique<Queue>());
+        for (size_t id{0}; id < threads; ++id)
+            m_workers.emplace_back(&ThreadPool::workerLoop, this, id);
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+
+        for (auto &worker : m_workers)
+            worker.join();
+    }
+
+    bool ThreadPool::takeTask(size_t id, Task *task)
+    {
+        {
+            auto &own = *m_queues[id];
+            const std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty())
+            {
+                *task = own.tasks.front();
+                own.tasks.pop_front();
+                return true;
+            }
+        }
+
+        for (size_t offset{1}; offset < m_queues.size(); ++offset)
+        {
+            auto &victim = *m_queues[(id + offset) % m_queues.size()];
+            const std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty())
+            {
+                *task = victim.tasks.back();
+                victim.tasks.pop_back();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void ThreadPool::workerLoop(size_t id)
+    {
+        size_t lastBatch{0};
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wake.wait(lock, [this, lastBatch]()
+                            { return m_stop || m_batch != lastBatch; });
+                if (m_stop)
+                    return;
+                lastBatch = m_batch;
+            }
+
+            Task task;
+            while (takeTask(id, &task))
+            {
+                const auto start = std::chrono::steady_clock::now();
+                std::exception_ptr error = nullptr;
+                try
+                {
+                    (*task.function)(task.index);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+                const std::lock_guard<std::mutex> lock(m_mutex);
+                m_busySeconds += elapsed.count();
+                if (error && !m_error)
+                    m_error = error;
+                if (--m_remaining == 0)
+                    m_done.notify_all();
+            }
+        }
+    }
+
+    void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)> &task)
+    {
+        if (count == 0)
+            return;
+
+        if (m_workers.empty())
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t index{0}; index < count; ++index)
+                task(index);
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            m_busySeconds += elapsed.count();
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        /* Contiguous shares keep neighbouring rows on one core until stealing kicks in */
+        const auto workers = m_queues.size();
+        for (size_t id{0}; id < workers; ++id)
+        {
+            auto &queue = *m_queues[id];
+            const std::lock_guard<std::mutex> queueLock(queue.mutex);
+            for (size_t index{id * count / workers}; index < (id + 1) * count / workers; ++index)
+                queue.tasks.push_back(Task{&task, index});
+        }
+
+        m_remaining = count;
+        m_error = nullptr;
+        ++m_batch;
+        m_wake.notify_all();
+
+        m_done.wait(lock, [this]()
+                    { return m_remaining == 0; });
+
+        if (m_error)
+            std::rethrow_exception(m_error);
+    }
+
+    double ThreadPool::takeBusySeconds()
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        const auto busySeconds = m_busySeconds;
+        m_busySeconds = 0;
+        return busySeconds;
+    }
+}
@@ -0,0 +1,273 @@
+#include "trainer.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+namespace VSOMExplorer
+{
+    double Trainer::neighbourhood(size_t a, size_t b, size_t width, double sigma)
+    {
+        const auto dx = static_cast<double>(a % width) - static_cast<double>(b % width);
+        const auto dy = static_cast<double>(a / width) - static_cast<double>(b / width);
+        return std::exp(-(dx * dx + dy * dy) / (2.0 * sigma * sigma));
+    }
+
+    double Trainer::onlineEta(const TrainingParameters &parameters, size_t epoch)
+    {
+        if (parameters.decayFunction == Som::WeigthDecayFunction::Exponential)
+            return parameters.eta0 * std::exp(-parameters.etaDecay * static_cast<double>(epoch));
+
+        return 1.0 / (1.0 + static_cast<double>(epoch));
+    }
+
+    double Trainer::onlineEpoch(Codebook &codebook, BmuSearch &search, const DataMatrix &data,
+                                const std::vector<size_t> &rows, std::vector<size_t> &previousBmus,
+                                double eta, double sigma, size_t epoch)
+    {
+        const auto width = static_cast<long>(codebook.getWidth());
+        const auto height = static_cast<long>(codebook.getHeight());
+        const auto depth = codebook.getDepth();
+        const auto radius = static_cast<long>(std::ceil(3.0 * sigma));
+        double squaredErrorSum{0};
+
+        for (const auto row : rows)
+        {
+            const auto *sample = data.getRow(row);
+            const auto bmu = search.find(sample, previousBmus[row], (row + epoch) % verificationInterval == 0);
+            previousBmus[row] = bmu;
+            squaredErrorSum += search.distance(sample, bmu);
+
+            /* Only neurons within three sigma contribute noticeably */
+            const auto bmuX = static_cast<long>(bmu) % width;
+            const auto bmuY = static_cast<long>(bmu) / width;
+            for (auto y = std::max(0L, bmuY - radius); y <= std::min(height - 1, bmuY + radius); ++y)
+            {
+                for (auto x = std::max(0L, bmuX - radius); x <= std::min(width - 1, bmuX + radius); ++x)
+                {
+                    const auto index = codebook.getIndex(static_cast<size_t>(x), static_cast<size_t>(y));
+                    const auto learningRate = static_cast<float>(eta * neighbourhood(bmu, index, codebook.getWidth(), sigma));
+                    auto *neuron = codebook.getNeuron(index);
+
+                    for (size_t i{0}; i < depth; ++i)
+                        neuron[i] += learningRate * (sample[i] - neuron[i]);
+                }
+            }
+        }
+
+        return rows.size() > 0 ? squaredErrorSum / static_cast<double>(rows.size()) : 0.0;
+    }
+
+    double Trainer::batchEpoch(Codebook &codebook, BmuSearch &search, const DataMatrix &data,
+                               const std::vector<size_t> &rows, std::vector<size_t> &previousBmus,
+                               double sigma, size_t epoch, ThreadPool &pool)
+    {
+        const auto width = static_cast<long>(codebook.getWidth());
+        const auto height = static_cast<long>(codebook.getHeight());
+        const auto depth = codebook.getDepth();
+        const auto radius = static_cast<long>(std::ceil(3.0 * sigma));
+
+        /* BMUs per row, the codebook is read only until the smoothing step */
+        const auto rowTasks = (rows.size() + rowsPerTask - 1) / rowsPerTask;
+        auto squaredErrors = std::vector<double>(rowTasks, 0.0);
+
+        pool.parallelFor(rowTasks, [&](size_t task)
+                         {
+            double squaredErrorSum{0};
+            for (size_t entry{task * rowsPerTask}; entry < std::min(rows.size(), (task + 1) * rowsPerTask); ++entry)
+            {
+                const auto row = rows[entry];
+                const auto *sample = data.getRow(row);
+                const auto bmu = search.find(sample, previousBmus[row], (row + epoch) % verificationInterval == 0);
+                previousBmus[row] = bmu;
+                squaredErrorSum += search.distance(sample, bmu);
+            }
+            squaredErrors[task] = squaredErrorSum; });
+
+        /* Rows grouped by BMU in ascending row order, so every neuron sums its samples
+           in the same order no matter how the rows were split */
+        auto rowOffsets = std::vector<size_t>(codebook.size() + 1, 0);
+        for (const auto row : rows)
+            ++rowOffsets[previousBmus[row] + 1];
+        for (size_t index{0}; index < codebook.size(); ++index)
+            rowOffsets[index + 1] += rowOffsets[index];
+
+        auto rowsByNeuron = std::vector<size_t>(rows.size());
+        {
+            auto next = std::vector<size_t>(rowOffsets.begin(), rowOffsets.end() - 1);
+            for (const auto row : rows)
+                rowsByNeuron[next[previousBmus[row]]++] = row;
+        }
+
+        /* Per neuron sums and hit counts of the samples mapped to it */
+        auto sums = std::vector<double>(codebook.size() * depth, 0.0);
+        auto hits = std::vector<double>(codebook.size(), 0.0);
+        const auto neuronTasks = (codebook.size() + neuronsPerTask - 1) / neuronsPerTask;
+
+        pool.parallelFor(neuronTasks, [&](size_t task)
+                         {
+            for (size_t index{task * neuronsPerTask}; index < std::min(codebook.size(), (task + 1) * neuronsPerTask); ++index)
+            {
+                auto *sum = sums.data() + index * depth;
+                for (auto entry = rowOffsets[index]; entry < rowOffsets[index + 1]; ++entry)
+                {
+                    const auto *sample = data.getRow(rowsByNeuron[entry]);
+                    for (size_t i{0}; i < depth; ++i)
+                        sum[i] += sample[i];
+                }
+                hits[index] = static_cast<double>(rowOffsets[index + 1] - rowOffsets[index]);
+            } });
+
+        /* Neighbourhood smoothed means, one map row per task */
+        pool.parallelFor(static_cast<size_t>(height), [&](size_t task)
+                         {
+            const auto y = static_cast<long>(task);
+            auto numerator = std::vector<double>(depth);
+
+            for (long x{0}; x < width; ++x)
+            {
+                const auto index = codebook.getIndex(static_cast<size_t>(x), static_cast<size_t>(y));
+                std::fill(numerator.begin(), numerator.end(), 0.0);
+                double denominator{0};
+
+                for (auto ny = std::max(0L, y - radius); ny <= std::min(height - 1, y + radius); ++ny)
+                {
+                    for (auto nx = std::max(0L, x - radius); nx <= std::min(width - 1, x + radius); ++nx)
+                    {
+                        const auto other = codebook.getIndex(static_cast<size_t>(nx), static_cast<size_t>(ny));
+                        if (hits[other] == 0.0)
+                            continue;
+
+                        const auto h = neighbourhood(index, other, codebook.getWidth(), sigma);
+                        const auto *sum = sums.data() + other * depth;
+                        for (size_t i{0}; i < depth; ++i)
+                            numerator[i] += h * sum[i];
+                        denominator += h * hits[other];
+                    }
+                }
+
+                if (denominator <= 0.0)
+                    continue;
+
+                auto *neuron = codebook.getNeuron(index);
+                for (size_t i{0}; i < depth; ++i)
+                    neuron[i] = static_cast<float>(numerator[i] / denominator);
+            } });
+
+        double squaredErrorSum{0};
+        for (const auto squaredError : squaredErrors)
+            squaredErrorSum += squaredError;
+
+        return rows.size() > 0 ? squaredErrorSum / static_cast<double>(rows.size()) : 0.0;
+    }
+
+    bool Trainer::start(Som &som, std::shared_ptr<const DataMatrix> data, std::vector<float> weights, TrainingParameters parameters)
+    {
+        if (m_training)
+            return false;
+        if (m_thread.joinable())
+            m_thread.join();
+
+        m_training = true;
+        m_stopRequested = false;
+        m_thread = std::thread([this, &som, data = std::move(data), weights = std::move(weights), parameters]() mutable
+                               {
+            try
+            {
+                train(som, std::move(data), std::move(weights), parameters);
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << "Training stopped: " << e.what() << '\n';
+                m_training = false;
+            } });
+        return true;
+    }
+
+    void Trainer::stop()
+    {
+        m_stopRequested = true;
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    void Trainer::publish(const Codebook &codebook)
+    {
+        const std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        m_snapshot = codebook;
+        ++m_snapshotVersion;
+    }
+
+    bool Trainer::takeSnapshot(Codebook &target, size_t &version) const
+    {
+        const std::lock_guard<std::mutex> lock(m_snapshotMutex);
+        if (m_snapshotVersion == version)
+            return false;
+
+        target = m_snapshot;
+        version = m_snapshotVersion;
+        return true;
+    }
+
+    void Trainer::train(Som &som, std::shared_ptr<const DataMatrix> dataPointer, std::vector<float> weights, TrainingParameters parameters)
+    {
+        m_training = true;
+        const auto &data = *dataPointer;
+        {
+            const std::lock_guard<std::mutex> lock(metricsMutex);
+            m_metrics = TrainerMetrics{};
+        }
+
+        auto codebook = Codebook::fromSom(som);
+        auto search = BmuSearch(codebook, weights, parameters.searchMode);
+        auto previousBmus = std::vector<size_t>(data.size(), BmuSearch::noPreviousBmu);
+        auto pool = ThreadPool(parameters.decayFunction == Som::WeigthDecayFunction::BatchMap ? parameters.threads : 1);
+        auto sampler = EpochSampler(data, parameters.sampling, parameters.sampleFraction, parameters.sampleSize,
+                                    parameters.labelColumn, parameters.seed);
+        const auto epochs = parameters.numberOfEpochs + (sampler.isSampling() && parameters.finalFullPass ? 1 : 0);
+        {
+            const std::lock_guard<std::mutex> lock(metricsMutex);
+            m_metrics.Threads = pool.size();
+            m_metrics.Rows = data.size();
+        }
+
+        publish(codebook);
+        if (m_epochCallback)
+            m_epochCallback(0, codebook);
+
+        /* Oversubscribed workers are timesliced, which inflates their busy time */
+        const auto maxSpeedup = static_cast<double>(std::min<size_t>(pool.size(), std::max(1u, std::thread::hardware_concurrency())));
+
+        for (size_t epoch{0}; epoch < epochs && !m_stopRequested; ++epoch)
+        {
+            const auto sigma = std::max(parameters.sigma0 * std::exp(-parameters.sigmaDecay * static_cast<double>(epoch)), 0.5);
+
+            const auto start = std::chrono::steady_clock::now();
+            pool.takeBusySeconds();
+            search.rebuild();
+            search.resetRecall();
+            const auto &rows = sampler.next(epoch >= parameters.numberOfEpochs);
+
+            const auto meanSquaredError = parameters.decayFunction == Som::WeigthDecayFunction::BatchMap
+                                              ? batchEpoch(codebook, search, data, rows, previousBmus, sigma, epoch, pool)
+                                              : onlineEpoch(codebook, search, data, rows, previousBmus, onlineEta(parameters, epoch), sigma, epoch);
+
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            const auto busySeconds = pool.takeBusySeconds();
+
+            codebook.applyTo(som);
+            publish(codebook);
+            if (m_epochCallback)
+                m_epochCallback(epoch + 1, codebook);
+
+            const std::lock_guard<std::mutex> lock(metricsMutex);
+            m_metrics.MeanSquaredError.push_back(static_cast<float>(meanSquaredError));
+            m_metrics.BmuRecall.push_back(search.getRecall());
+            m_metrics.LastEpochRows = rows.size();
+            m_metrics.EpochSeconds.push_back(static_cast<float>(elapsed.count()));
+            m_metrics.Speedup.push_back(pool.size() > 1 && elapsed.count() > 0 ? static_cast<float>(std::min(busySeconds / elapsed.count(), maxSpeedup)) : 1.f);
+        }
+
+        m_training = false;
+    }
+}
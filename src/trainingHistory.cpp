@@ -0,0 +1,287 @@
+#include "trainingHistory.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace VSOMExplorer
+{
+    namespace
+    {
+        void putLength(std::vector<uint8_t> &out, size_t value)
+        {
+            while (value >= 0x80)
+            {
+                out.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        size_t getLength(const uint8_t *&in)
+        {
+            size_t value{0};
+            for (size_t shift{0};; shift += 7)
+            {
+                const auto byte = *in++;
+                value |= static_cast<size_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0)
+                    return value;
+            }
+        }
+
+        /* Byte planes of bits ^ base, as alternating zero runs and literal runs */
+        std::vector<uint8_t> encode(const std::vector<uint32_t> &bits, const std::vector<uint32_t> *base)
+        {
+            const auto count = bits.size();
+            auto planes = std::vector<uint8_t>(count * 4);
+            for (size_t i{0}; i < count; ++i)
+            {
+                const auto delta = base != nullptr ? bits[i] ^ (*base)[i] : bits[i];
+                for (size_t plane{0}; plane < 4; ++plane)
+                    planes[plane * count + i] = static_cast<uint8_t>(delta >> (8 * plane));
+            }
+
+            auto out = std::vector<uint8_t>{};
+            size_t position{0};
+            while (position < planes.size())
+            {
+                auto end = position;
+                while (end < planes.size() && planes[end] == 0)
+                    ++end;
+                putLength(out, end - position);
+
+                position = end;
+                /* Literal runs end at the first pair of zeros, a lone zero is cheaper inline */
+                while (end < planes.size() && !(planes[end] == 0 && (end + 1 == planes.size() || planes[end + 1] == 0)))
+                    ++end;
+                putLength(out, end - position);
+                out.insert(out.end(), planes.begin() + static_cast<long>(position), planes.begin() + static_cast<long>(end));
+                position = end;
+            }
+
+            out.shrink_to_fit();
+            return out;
+        }
+
+        /* Applies an encoded delta onto bits in place */
+        void apply(const std::vector<uint8_t> &data, std::vector<uint32_t> &bits)
+        {
+            const auto count = bits.size();
+            const auto *in = data.data();
+            const auto *end = data.data() + data.size();
+            size_t position{0};
+
+            while (in < end)
+            {
+                position += getLength(in);
+                const auto literals = getLength(in);
+
+                auto plane = position / count;
+                auto index = position % count;
+                position += literals;
+                for (size_t i{0}; i < literals; ++i)
+                {
+                    bits[index] ^= static_cast<uint32_t>(*in++) << (8 * plane);
+                    if (++index == count)
+                    {
+                        index = 0;
+                        ++plane;
+                    }
+                }
+            }
+        }
+    }
+
+    void TrainingHistory::setInterval(size_t epochs)
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_interval = std::max<size_t>(epochs, 1);
+    }
+
+    void TrainingHistory::setMemoryCap(size_t bytes)
+    {
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        m_memoryCap = bytes;
+        trim(lock);
+    }
+
+    void TrainingHistory::setEnabled(bool enabled)
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_enabled = enabled;
+    }
+
+    size_t TrainingHistory::getInterval() const
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return m_interval;
+    }
+
+    size_t TrainingHistory::getMemoryCap() const
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return m_memoryCap;
+    }
+
+    bool TrainingHistory::isEnabled() const
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return m_enabled;
+    }
+
+    void TrainingHistory::record(size_t epoch, const Codebook &codebook, bool last)
+    {
+        /* Only the bookkeeping runs under the lock, a reader decoding on the UI thread never waits for an encode */
+        auto base = std::vector<uint32_t>{};
+        auto keyframe = false;
+        size_t resets{0};
+        {
+            const std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_enabled || (!last && epoch % m_interval != 0) || codebook.empty())
+                return;
+
+            if (codebook.getWidth() != m_width || codebook.getHeight() != m_height || codebook.getDepth() != m_depth)
+            {
+                m_snapshots.clear();
+                m_previous.clear();
+                m_bytes = 0;
+                m_width = codebook.getWidth();
+                m_height = codebook.getHeight();
+                m_depth = codebook.getDepth();
+                ++m_resets;
+            }
+
+            keyframe = m_snapshots.empty() || m_previous.empty() || ++m_sinceKeyframe >= keyframeInterval;
+            if (keyframe)
+                m_sinceKeyframe = 0;
+            base = std::move(m_previous);
+            m_previous.clear();
+            resets = m_resets;
+        }
+
+        auto bits = std::vector<uint32_t>(codebook.getValues().size());
+        std::memcpy(bits.data(), codebook.getValues().data(), bits.size() * sizeof(uint32_t));
+        auto snapshot = Snapshot{epoch, keyframe, encode(bits, keyframe ? nullptr : &base)};
+
+        auto lock = std::unique_lock<std::mutex>(m_mutex);
+        /* Cleared while encoding, the delta has no base any more */
+        if (m_resets != resets)
+            return;
+
+        m_bytes += snapshot.data.size();
+        m_snapshots.push_back(std::move(snapshot));
+        m_previous = std::move(bits);
+        trim(lock);
+    }
+
+    void TrainingHistory::trim(std::unique_lock<std::mutex> &lock)
+    {
+        const auto resets = m_resets;
+        while (m_snapshots.size() > 1 && usedBytes() > m_memoryCap)
+        {
+            /* The next snapshot becomes the front, so it has to stand on its own. The front is always a
+               keyframe, so the next one decodes from the two of them, rebuilt without holding the lock. */
+            if (!m_snapshots[1].keyframe)
+            {
+                const auto front = m_snapshots[0].data;
+                const auto next = m_snapshots[1].data;
+                const auto nextEpoch = m_snapshots[1].epoch;
+                auto bits = std::vector<uint32_t>(m_width * m_height * m_depth, 0u);
+
+                lock.unlock();
+                apply(front, bits);
+                apply(next, bits);
+                auto data = encode(bits, nullptr);
+                lock.lock();
+
+                if (m_resets != resets || m_snapshots.size() < 2 || m_snapshots[1].epoch != nextEpoch)
+                    return;
+                if (!m_snapshots[1].keyframe)
+                {
+                    m_bytes -= m_snapshots[1].data.size();
+                    m_snapshots[1].data = std::move(data);
+                    m_snapshots[1].keyframe = true;
+                    m_bytes += m_snapshots[1].data.size();
+                }
+            }
+
+            m_bytes -= m_snapshots.front().data.size();
+            m_snapshots.pop_front();
+        }
+    }
+
+    void TrainingHistory::clear()
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_snapshots.clear();
+        m_previous.clear();
+        m_sinceKeyframe = 0;
+        m_bytes = 0;
+        ++m_resets;
+    }
+
+    size_t TrainingHistory::size() const
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return m_snapshots.size();
+    }
+
+    size_t TrainingHistory::epochAt(size_t index) const
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return index < m_snapshots.size() ? m_snapshots[index].epoch : 0;
+    }
+
+    size_t TrainingHistory::findEpoch(size_t epoch) const
+    {
+        /* Snapshots are recorded in epoch order */
+        const auto found = std::lower_bound(m_snapshots.begin(), m_snapshots.end(), epoch, [](const Snapshot &snapshot, size_t value)
+                                            { return snapshot.epoch < value; });
+        const auto index = static_cast<size_t>(found - m_snapshots.begin());
+        return m_snapshots.empty() ? 0 : std::min(index, m_snapshots.size() - 1);
+    }
+
+    size_t TrainingHistory::indexOf(size_t epoch) const
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return findEpoch(epoch);
+    }
+
+    size_t TrainingHistory::memoryBytes() const
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return usedBytes();
+    }
+
+    size_t TrainingHistory::rawBytes() const
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return m_snapshots.size() * m_width * m_height * m_depth * sizeof(float);
+    }
+
+    void TrainingHistory::decodeInto(size_t index, std::vector<uint32_t> &bits) const
+    {
+        auto keyframe = index;
+        while (!m_snapshots[keyframe].keyframe)
+            --keyframe;
+
+        std::fill(bits.begin(), bits.end(), 0u);
+        for (auto current = keyframe; current <= index; ++current)
+            apply(m_snapshots[current].data, bits);
+    }
+
+    std::optional<Codebook> TrainingHistory::decode(size_t epoch) const
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_snapshots.empty())
+            return std::nullopt;
+
+        const auto index = findEpoch(epoch);
+        auto bits = std::vector<uint32_t>(m_width * m_height * m_depth);
+        decodeInto(index, bits);
+
+        auto codebook = Codebook(m_width, m_height, m_depth);
+        std::memcpy(codebook.getNeuron(0), bits.data(), bits.size() * sizeof(uint32_t));
+        return codebook;
+    }
+}
@@ -0,0 +1,144 @@
+#include "viewCache.h"
+
+#include "mapRaster.h"
+
+#include <algorithm>
+
+namespace VSOMExplorer
+{
+    namespace
+    {
+        void featureRange(const Codebook &codebook, std::vector<float> &minimum, std::vector<float> &maximum)
+        {
+            const auto depth = codebook.getDepth();
+            minimum.assign(depth, std::numeric_limits<float>::max());
+            maximum.assign(depth, std::numeric_limits<float>::lowest());
+
+            for (size_t index{0}; index < codebook.size(); ++index)
+            {
+                const auto *neuron = codebook.getNeuron(index);
+                for (size_t i{0}; i < depth; ++i)
+                {
+                    minimum[i] = std::min(minimum[i], neuron[i]);
+                    maximum[i] = std::max(maximum[i], neuron[i]);
+                }
+            }
+        }
+
+        template <typename Values>
+        void fillGrid(ValueGrid &grid, size_t width, size_t height, const Values &values)
+        {
+            grid.width = width;
+            grid.height = height;
+            grid.values.resize(width * height);
+            for (size_t i{0}; i < grid.values.size(); ++i)
+                grid.values[i] = static_cast<float>(values[i]);
+            grid.maxValue = grid.values.empty() ? 0.f : *std::max_element(grid.values.begin(), grid.values.end());
+        }
+    }
+
+    void ModelViews::refresh(const Som &som, size_t newGeneration)
+    {
+        generation = newGeneration;
+        ++revision;
+
+        codebook = Codebook::fromSom(som);
+        sigma = Codebook::sigmaFromSom(som);
+        featureRange(codebook, featureMin, featureMax);
+        featureRange(sigma, sigmaMin, sigmaMax);
+
+        const auto width = som.getWidth();
+        const auto height = som.getHeight();
+        fillGrid(weightMap, width, height, som.getWeigthMap());
+        fillGrid(bmuHits, width, height, som.getBmuHits());
+
+        /* Same U-matrix as the training refresh, the history and the export */
+        uMatrix = MapRaster::computeUMatrix(codebook);
+    }
+
+    void DatasetViews::refresh(DataSet &dataset, size_t newGeneration)
+    {
+        generation = newGeneration;
+
+        names = dataset.getNames();
+        labels.clear();
+        weightLabels.clear();
+        for (const auto &name : names)
+        {
+            labels.push_back(name.c_str());
+            weightLabels.push_back(name + " Weight");
+        }
+
+        hasPreviewText = false;
+        previewText.clear();
+        previewOffsets.clear();
+    }
+
+    void ModelViews::showSnapshot(Codebook snapshot, ValueGrid snapshotUMatrix, ValueGrid snapshotHits)
+    {
+        ++revision;
+
+        codebook = std::move(snapshot);
+        featureRange(codebook, featureMin, featureMax);
+        uMatrix = std::move(snapshotUMatrix);
+        if (!snapshotHits.values.empty())
+            bmuHits = std::move(snapshotHits);
+    }
+
+    void ModelViews::showTraining(const Codebook &snapshot, ValueGrid snapshotUMatrix)
+    {
+        ++revision;
+
+        codebook = snapshot;
+        featureRange(codebook, featureMin, featureMax);
+        uMatrix = std::move(snapshotUMatrix);
+    }
+
+    void DatasetViews::clearPreview()
+    {
+        hasPreviewText = false;
+        previewRows = 0;
+        previewColumns = 0;
+        previewText = std::vector<char>{};
+        previewOffsets = std::vector<size_t>{};
+    }
+
+    const uint8_t *ComponentPlanes::get(const Codebook &codebook, size_t revision, size_t feature, float min, float max)
+    {
+        if (revision != m_revision || m_planes.size() != codebook.getDepth())
+        {
+            m_revision = revision;
+            m_planes.resize(codebook.getDepth());
+            for (auto &plane : m_planes)
+                plane.clear();
+        }
+
+        auto &plane = m_planes[feature];
+        if (plane.empty() && codebook.size() > 0)
+        {
+            m_scratch.resize(codebook.size());
+            for (size_t index{0}; index < codebook.size(); ++index)
+                m_scratch[index] = codebook.getNeuron(index)[feature];
+
+            plane.resize(codebook.size());
+            scaleToBytes(m_scratch.data(), m_scratch.size(), min, max, plane.data());
+        }
+
+        return plane.data();
+    }
+
+    void ComponentPlanes::clear()
+    {
+        m_revision = ModelViews::noGeneration;
+        m_planes = std::vector<std::vector<uint8_t>>{};
+        m_scratch = std::vector<float>{};
+    }
+
+    size_t ComponentPlanes::memoryBytes() const
+    {
+        auto bytes = m_scratch.capacity() * sizeof(float);
+        for (const auto &plane : m_planes)
+            bytes += plane.capacity();
+        return bytes;
+    }
+}
@@ -0,0 +1,196 @@
+#include "workspace.h"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace VSOMExplorer
+{
+    namespace
+    {
+        /* The enums index name tables in the UI, a value past the last one is rejected */
+        template <typename Enum>
+        Enum parseEnum(const std::string &value, Enum last)
+        {
+            const auto parsed = std::stoi(value);
+            if (parsed < 0 || parsed > static_cast<int>(last))
+                throw std::out_of_range("no such value " + value);
+            return static_cast<Enum>(parsed);
+        }
+
+        /* Sizes that are allocated from at startup, a corrupt file must not ask for gigabytes */
+        constexpr int maxMapSide = 1024;
+        constexpr size_t maxThreads = 256;
+
+        size_t parseBounded(const std::string &value, size_t lowest, size_t highest)
+        {
+            const auto parsed = std::stoul(value);
+            if (parsed < lowest || parsed > highest)
+                throw std::out_of_range("no such value " + value);
+            return parsed;
+        }
+    }
+
+    bool Workspace::save(const std::string &path) const
+    {
+        auto file = std::ofstream(path);
+        if (!file)
+            return false;
+
+        file << "datasetPath=" << datasetPath << '\n'
+             << "modelPath=" << modelPath << '\n'
+             << "somWidth=" << somWidth << '\n'
+             << "somHeight=" << somHeight << '\n'
+             << "initSigma=" << initSigma << '\n'
+             << "seed=" << seed << '\n'
+             << "numberOfEpochs=" << training.numberOfEpochs << '\n'
+             << "eta0=" << training.eta0 << '\n'
+             << "etaDecay=" << training.etaDecay << '\n'
+             << "sigma0=" << training.sigma0 << '\n'
+             << "sigmaDecay=" << training.sigmaDecay << '\n'
+             << "decayFunction=" << static_cast<int>(training.decayFunction) << '\n'
+             << "searchMode=" << static_cast<int>(training.searchMode) << '\n'
+             << "threads=" << training.threads << '\n'
+             << "sampling=" << static_cast<int>(training.sampling) << '\n'
+             << "sampleFraction=" << training.sampleFraction << '\n'
+             << "sampleSize=" << training.sampleSize << '\n'
+             << "labelColumn=" << training.labelColumn << '\n'
+             << "finalFullPass=" << training.finalFullPass << '\n'
+             << "redColumnId=" << redColumnId << '\n'
+             << "greenColumnId=" << greenColumnId << '\n'
+             << "blueColumnId=" << blueColumnId << '\n'
+             << "uMatrixUpper=" << uMatrixRange.upper << '\n'
+             << "uMatrixLower=" << uMatrixRange.lower << '\n'
+             << "weightMapUpper=" << weightMapRange.upper << '\n'
+             << "weightMapLower=" << weightMapRange.lower << '\n'
+             << "bmuHitsUpper=" << bmuHitsRange.upper << '\n'
+             << "bmuHitsLower=" << bmuHitsRange.lower << '\n'
+             << "colormap=" << static_cast<int>(colormap) << '\n'
+             << "colormapEntries=" << colormapEntries << '\n'
+             << "bmuHitsLogScale=" << bmuHitsLogScale << '\n'
+             << "cacheBudgetMegabytes=" << cacheBudgetMegabytes << '\n'
+             << "historyEnabled=" << historyEnabled << '\n'
+             << "historyInterval=" << historyInterval << '\n'
+             << "historyMemoryCapMegabytes=" << historyMemoryCapMegabytes << '\n'
+             << "labelMapColumn=" << labelMapColumn << '\n'
+             << "showModelVectorsAsImage=" << showModelVectorsAsImage << '\n'
+             << "modelVectorAsImageWidth=" << modelVectorAsImageWidth << '\n'
+             << "modelVectorAsImageHeight=" << modelVectorAsImageHeight << '\n'
+             << "hexagonalTopology=" << hexagonalTopology << '\n';
+
+        return static_cast<bool>(file);
+    }
+
+    std::optional<Workspace> Workspace::load(const std::string &path)
+    {
+        auto file = std::ifstream(path);
+        if (!file)
+            return {};
+
+        auto workspace = Workspace{};
+        std::string line;
+        while (std::getline(file, line))
+        {
+            const auto separator = line.find('=');
+            if (separator == std::string::npos)
+                continue;
+
+            const auto key = line.substr(0, separator);
+            const auto value = line.substr(separator + 1);
+
+            try
+            {
+                if (key == "datasetPath")
+                    workspace.datasetPath = value;
+                else if (key == "modelPath")
+                    workspace.modelPath = value;
+                else if (key == "somWidth")
+                    workspace.somWidth = static_cast<int>(parseBounded(value, 1, maxMapSide));
+                else if (key == "somHeight")
+                    workspace.somHeight = static_cast<int>(parseBounded(value, 1, maxMapSide));
+                else if (key == "initSigma")
+                    workspace.initSigma = std::stof(value);
+                else if (key == "seed")
+                    workspace.seed = std::stoi(value);
+                else if (key == "numberOfEpochs")
+                    workspace.training.numberOfEpochs = std::stoul(value);
+                else if (key == "eta0")
+                    workspace.training.eta0 = std::stod(value);
+                else if (key == "etaDecay")
+                    workspace.training.etaDecay = std::stod(value);
+                else if (key == "sigma0")
+                    workspace.training.sigma0 = std::stod(value);
+                else if (key == "sigmaDecay")
+                    workspace.training.sigmaDecay = std::stod(value);
+                else if (key == "decayFunction")
+                    workspace.training.decayFunction = parseEnum(value, Som::WeigthDecayFunction::BatchMap);
+                else if (key == "searchMode")
+                    workspace.training.searchMode = parseEnum(value, BmuSearchMode::Local);
+                else if (key == "threads")
+                    workspace.training.threads = parseBounded(value, 1, maxThreads);
+                else if (key == "sampling")
+                    workspace.training.sampling = parseEnum(value, EpochSampling::Reservoir);
+                else if (key == "sampleFraction")
+                    workspace.training.sampleFraction = std::stod(value);
+                else if (key == "sampleSize")
+                    workspace.training.sampleSize = std::stoul(value);
+                else if (key == "labelColumn")
+                    workspace.training.labelColumn = std::stol(value);
+                else if (key == "finalFullPass")
+                    workspace.training.finalFullPass = std::stoi(value) != 0;
+                else if (key == "redColumnId")
+                    workspace.redColumnId = std::stoul(value);
+                else if (key == "greenColumnId")
+                    workspace.greenColumnId = std::stoul(value);
+                else if (key == "blueColumnId")
+                    workspace.blueColumnId = std::stoul(value);
+                else if (key == "uMatrixUpper")
+                    workspace.uMatrixRange.upper = std::stof(value);
+                else if (key == "uMatrixLower")
+                    workspace.uMatrixRange.lower = std::stof(value);
+                else if (key == "weightMapUpper")
+                    workspace.weightMapRange.upper = std::stof(value);
+                else if (key == "weightMapLower")
+                    workspace.weightMapRange.lower = std::stof(value);
+                else if (key == "bmuHitsUpper")
+                    workspace.bmuHitsRange.upper = std::stof(value);
+                else if (key == "bmuHitsLower")
+                    workspace.bmuHitsRange.lower = std::stof(value);
+                else if (key == "colormap")
+                    workspace.colormap = parseEnum(value, static_cast<ColormapName>(colormapCount - 1));
+                else if (key == "colormapEntries")
+                    workspace.colormapEntries = parseBounded(value, 2, Colormap::fineEntries);
+                else if (key == "bmuHitsLogScale")
+                    workspace.bmuHitsLogScale = std::stoi(value) != 0;
+                else if (key == "cacheBudgetMegabytes")
+                    workspace.cacheBudgetMegabytes = std::stoul(value);
+                else if (key == "historyEnabled")
+                    workspace.historyEnabled = std::stoi(value) != 0;
+                else if (key == "historyInterval")
+                    workspace.historyInterval = std::stoul(value);
+                else if (key == "historyMemoryCapMegabytes")
+                    workspace.historyMemoryCapMegabytes = std::stoul(value);
+                else if (key == "labelMapColumn")
+                    workspace.labelMapColumn = std::stol(value);
+                else if (key == "showModelVectorsAsImage")
+                    workspace.showModelVectorsAsImage = std::stoi(value) != 0;
+                else if (key == "modelVectorAsImageWidth")
+                    workspace.modelVectorAsImageWidth = std::stoi(value);
+                else if (key == "modelVectorAsImageHeight")
+                    workspace.modelVectorAsImageHeight = std::stoi(value);
+                else if (key == "hexagonalTopology")
+                    workspace.hexagonalTopology = std::stoi(value) != 0;
+            }
+            catch (const std::invalid_argument &e)
+            {
+                std::cerr << "Workspace " << path << ": ignoring " << key << " (" << e.what() << ")\n";
+            }
+            catch (const std::out_of_range &e)
+            {
+                std::cerr << "Workspace " << path << ": ignoring " << key << " (" << e.what() << ")\n";
+            }
+        }
+
+        return workspace;
+    }
+}
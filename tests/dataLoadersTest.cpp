@@ -0,0 +1,90 @@
+// Number parsing against strtof and the delimited reader's header and malformed row handling.
+// Run with make test.
+
+#include "dataLoaders.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+using namespace VSOMExplorer;
+
+namespace
+{
+    int failures{0};
+
+    void check(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "dataLoaders: %s\n", what);
+            ++failures;
+        }
+    }
+
+    bool parsesLikeStrtof(const char *text)
+    {
+        float value;
+        return parseFloat(text, text + std::strlen(text), &value) && value == std::strtof(text, nullptr);
+    }
+
+    void numbers()
+    {
+        /* Rounded to double first and then to float these come out one ulp off */
+        check(parsesLikeStrtof("8.456079959869385"), "8.456079959869385 rounded twice");
+        check(parsesLikeStrtof("0.6218869388103485"), "0.6218869388103485 rounded twice");
+        check(parsesLikeStrtof("67.14826583862304"), "67.14826583862304 rounded twice");
+
+        auto random = std::mt19937(7);
+        auto mantissa = std::uniform_real_distribution<double>(-1.0, 1.0);
+        auto scale = std::uniform_int_distribution<int>(-30, 30);
+        auto digits = std::uniform_int_distribution<int>(1, 17);
+        size_t mismatches{0};
+        for (size_t i{0}; i < 200000; ++i)
+        {
+            char text[64];
+            std::snprintf(text, sizeof(text), "%.*g", digits(random), std::ldexp(mantissa(random), scale(random)));
+            mismatches += parsesLikeStrtof(text) ? 0 : 1;
+        }
+        check(mismatches == 0, "random numbers differ from strtof");
+
+        float value;
+        check(!parseFloat("1.5x", "1.5x" + 4, &value), "trailing garbage accepted");
+        check(!parseFloat("", "", &value), "empty field accepted");
+    }
+
+    std::optional<DataMatrix> readText(const char *text)
+    {
+        const auto path = (std::filesystem::temp_directory_path() / "vsom-dataLoadersTest.csv").string();
+        std::ofstream(path) << text;
+        auto matrix = readDelimited(path, ',', 2);
+        std::filesystem::remove(path);
+        return matrix;
+    }
+
+    void delimited()
+    {
+        const auto named = readText("x,y\n1,2\n3,4\n");
+        check(named && named->size() == 2 && named->getNames()[1] == "y", "header line not taken as names");
+
+        const auto unnamed = readText("1,2\n3,4\n");
+        check(unnamed && unnamed->size() == 2 && unnamed->getRow(0)[1] == 2.f, "numeric first line not taken as data");
+
+        check(!readText("1,oops\n3,4\n"), "first line with a number and a word read as a header");
+        check(!readText("x,y\n1,2\n3,\n"), "row with a missing field accepted");
+        check(!readText("x,y\n1,2\n3,four\n"), "row with an unreadable field accepted");
+    }
+}
+
+int main()
+{
+    numbers();
+    delimited();
+
+    std::printf("dataLoaders: %s\n", failures == 0 ? "passed" : "failed");
+    return failures == 0 ? 0 : 1;
+}
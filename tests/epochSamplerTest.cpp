@@ -0,0 +1,87 @@
+// Stratified epoch sampling on label columns that are not clean class labels: rows without a
+// label and columns with a value per row. Run with make test.
+
+#include "epochSampler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+using namespace VSOMExplorer;
+
+namespace
+{
+    int failures{0};
+
+    void check(bool condition, const char *what)
+    {
+        if (!condition)
+        {
+            std::fprintf(stderr, "epochSampler: %s\n", what);
+            ++failures;
+        }
+    }
+
+    DataMatrix labelledMatrix(size_t rows, float (*label)(size_t))
+    {
+        auto data = DataMatrix(rows, 2);
+        for (size_t row{0}; row < rows; ++row)
+        {
+            data.getRow(row)[0] = static_cast<float>(row);
+            data.getRow(row)[1] = label(row);
+        }
+        return data;
+    }
+
+    void nanLabels()
+    {
+        /* Every third row has no label */
+        const auto data = labelledMatrix(3000, [](size_t row)
+                                         { return row % 3 == 2 ? std::numeric_limits<float>::quiet_NaN() : static_cast<float>(row % 3); });
+
+        for (const auto sampling : {EpochSampling::Fraction, EpochSampling::Reservoir})
+        {
+            auto sampler = EpochSampler(data, sampling, 0.5, 500, 1, 7);
+            check(sampler.getStrataCount() == 2, "NaN labels formed a stratum");
+            check(!sampler.hasTooManyClasses(), "two classes taken as too many");
+
+            const auto &rows = sampler.next();
+            check(rows.size() == (sampling == EpochSampling::Fraction ? 1000u : 500u), "sample size ignores the unlabelled rows");
+            check(std::none_of(rows.begin(), rows.end(), [](size_t row)
+                               { return row % 3 == 2; }),
+                  "unlabelled row sampled");
+            check(sampler.next(true).size() == data.size(), "full epoch left out unlabelled rows");
+        }
+
+        const auto unlabelled = labelledMatrix(100, [](size_t)
+                                               { return std::numeric_limits<float>::quiet_NaN(); });
+        auto sampler = EpochSampler(unlabelled, EpochSampling::Reservoir, 0.5, 10, 1, 7);
+        check(sampler.getStrataCount() == 1 && sampler.next().size() == 10, "column without labels samples unstratified");
+    }
+
+    void continuousColumn()
+    {
+        const auto data = labelledMatrix(10000, [](size_t row)
+                                         { return static_cast<float>(row) * 0.1f; });
+        auto sampler = EpochSampler(data, EpochSampling::Reservoir, 0.5, 1000, 1, 7);
+        check(sampler.hasTooManyClasses(), "continuous column taken as labels");
+        check(sampler.getStrataCount() == 1, "continuous column stratified");
+        check(sampler.next().size() == 1000, "continuous column sample size");
+
+        const auto limit = labelledMatrix(EpochSampler::maxClasses * 4, [](size_t row)
+                                          { return static_cast<float>(row % EpochSampler::maxClasses); });
+        auto atLimit = EpochSampler(limit, EpochSampling::Reservoir, 0.5, 512, 1, 7);
+        check(!atLimit.hasTooManyClasses() && atLimit.getStrataCount() == EpochSampler::maxClasses, "maxClasses classes rejected");
+        check(atLimit.next().size() == 512, "sample size at maxClasses");
+    }
+}
+
+int main()
+{
+    nanLabels();
+    continuousColumn();
+
+    std::printf("epochSampler: %s\n", failures == 0 ? "passed" : "failed");
+    return failures == 0 ? 0 : 1;
+}
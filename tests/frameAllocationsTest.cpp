@@ -0,0 +1,93 @@
+// Renders explorer frames without a platform or renderer backend and checks that steady state
+// frames make no heap allocations. Built with the allocation counter by make test
+
+#include "allocationCounter.h"
+#include "dataLoaders.h"
+#include "explorer.h"
+
+#include <imgui/imgui.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+using namespace VSOMExplorer;
+
+namespace
+{
+    constexpr size_t warmUpFrames = 60;
+    constexpr size_t measuredFrames = 240;
+
+    void renderFrame(Handler &explorer)
+    {
+        auto &io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(1280.f, 720.f);
+        io.DeltaTime = 1.f / 60.f;
+
+        ImGui::NewFrame();
+        explorer.RenderExplorer();
+        ImGui::Render();
+    }
+
+    void writeDataset(const std::string &path)
+    {
+        auto file = std::ofstream(path);
+        file << "a,b,c,label\n";
+        for (size_t row{0}; row < 500; ++row)
+            file << row % 7 << ',' << row % 11 << ',' << row % 13 << ',' << row % 3 << '\n';
+    }
+}
+
+int main()
+{
+    if (!AllocationCounter::isEnabled())
+    {
+        std::fprintf(stderr, "frameAllocations: build with -DVSOM_COUNT_ALLOCATIONS\n");
+        return 1;
+    }
+
+    AllocationCounter::installImGuiAllocator();
+    ImGui::CreateContext();
+    auto &io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+
+    /* The null backend: the font atlas is built but never uploaded and the draw data is dropped */
+    unsigned char *pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    const auto datasetPath = (std::filesystem::temp_directory_path() / "vsom-frameAllocations.csv").string();
+    writeDataset(datasetPath);
+    auto loader = openDataLoader(datasetPath, "");
+    if (loader == nullptr)
+    {
+        std::fprintf(stderr, "frameAllocations: could not read %s\n", datasetPath.c_str());
+        return 1;
+    }
+
+    int failures{0};
+    {
+        auto explorer = Handler{};
+        explorer.SetDataset(std::unique_ptr<DataSet>(new DataSet(*loader)));
+
+        for (size_t frame{0}; frame < warmUpFrames; ++frame)
+            renderFrame(explorer);
+
+        const auto heapAllocationsBefore = AllocationCounter::heapAllocations();
+        const auto imGuiAllocationsBefore = AllocationCounter::imGuiAllocations();
+        for (size_t frame{0}; frame < measuredFrames; ++frame)
+            renderFrame(explorer);
+        const auto heapAllocations = AllocationCounter::heapAllocations() - heapAllocationsBefore;
+        const auto imGuiAllocations = AllocationCounter::imGuiAllocations() - imGuiAllocationsBefore;
+
+        std::printf("frameAllocations: %zu heap and %zu ImGui allocations in %zu frames\n", heapAllocations, imGuiAllocations, measuredFrames);
+        if (heapAllocations != 0)
+            ++failures;
+    }
+
+    ImGui::DestroyContext();
+    std::filesystem::remove(datasetPath);
+    return failures == 0 ? 0 : 1;
+}